@@ -0,0 +1,30 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <sharg/parser.hpp>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/ibf_query_cost.hpp>
+
+namespace chopper
+{
+
+/*!\brief Measures the relative query cost of an IBF for different t_max and FPRs on this machine.
+ * \details
+ * For every FPR in `config.calibration_fprs` and every power of two t_max in [64, config.calibration_max_tmax],
+ * an IBF is filled with random values and queried. The cost factors are the query times relative to t_max = 64.
+ * Cost factors for larger t_max are extrapolated with the growth of `config.query_cost`, by default the built-in
+ * table. Without `config.calibration_fprs`, the FPRs of `config.query_cost` are measured.
+ */
+chopper::layout::ibf_query_cost::table_type calibrate_query_cost(chopper::configuration const & config);
+
+//!\brief Measures the query cost (see calibrate_query_cost()) and writes the table to `config.query_cost_table`.
+int chopper_calibrate(chopper::configuration & config, sharg::parser & parser);
+
+} // namespace chopper
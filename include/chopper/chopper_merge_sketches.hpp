@@ -0,0 +1,20 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <sharg/parser.hpp>
+
+#include <chopper/configuration.hpp>
+
+namespace chopper
+{
+
+//!\brief Combines the sketch files of all shards (see `chopper sketch --shard`) into a single sketch file.
+int chopper_merge_sketches(chopper::configuration & config, sharg::parser & parser);
+
+} // namespace chopper
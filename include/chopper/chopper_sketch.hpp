@@ -0,0 +1,20 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <sharg/parser.hpp>
+
+#include <chopper/configuration.hpp>
+
+namespace chopper
+{
+
+//!\brief Computes the sketches of (a shard of) the data file and writes them to a sketch file. No layout is computed.
+int chopper_sketch(chopper::configuration & config, sharg::parser & parser);
+
+} // namespace chopper
@@ -0,0 +1,22 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <sharg/parser.hpp>
+
+#include <chopper/configuration.hpp>
+
+namespace chopper
+{
+
+/*!\brief Lays out a sketch file for every combination of the `--fpr`, `--relaxed-fpr`, `--hash`, `--alpha` and `--tmax`
+ *        values and writes a table with the size and expected query cost of each layout (see layout::sweep()).
+ */
+int chopper_sweep(chopper::configuration & config, sharg::parser & parser);
+
+} // namespace chopper
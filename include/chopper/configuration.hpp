@@ -10,9 +10,14 @@
 #include <cinttypes>
 #include <filesystem>
 #include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <cereal/cereal.hpp>
 
+#include <chopper/layout/ibf_query_cost.hpp>
+
 #include <hibf/cereal/path.hpp> // IWYU pragma: keep
 #include <hibf/config.hpp>
 #include <hibf/misc/timer.hpp>
@@ -20,6 +25,11 @@
 namespace chopper
 {
 
+namespace sketch
+{
+class similarity_store;
+} // namespace sketch
+
 struct configuration
 {
     /*!\name General Configuration
@@ -45,6 +55,14 @@ struct configuration
 
     //!\brief Whether the input files are precomputed files (.minimiser) instead of sequence files.
     bool precomputed_files{false};
+
+    /*!\brief The FPR of each user bin, given by a field `fpr=<number>` in the data file. 0 means no FPR was given.
+     * \details
+     * May be empty if no user bin has an FPR. User bins without an FPR use `hibf_config.maximum_fpr`.
+     * The layout uses the strictest FPR of its user bins, see chopper::layout::use_strictest_fpr.
+     * \see chopper::layout::user_bin_fpr
+     */
+    std::vector<double> user_bin_fprs{};
     //!\}
 
     /*!\name Configuration of size estimates
@@ -55,6 +73,30 @@ struct configuration
 
     //!\brief Do not write the sketches into a dedicated directory.
     bool disable_sketch_output{false};
+
+    /*!\brief The number of most similar user bins to store per user bin next to the sketch file. 0 disables it.
+     * \see chopper::sketch::similarity_store
+     */
+    size_t similarity_neighbours{0u};
+    //!\}
+
+    /*!\name Sketching in shards (`chopper sketch` and `chopper merge-sketches`)
+     * \{
+     */
+    //!\brief The shard of the data file to sketch, given as "i/n" on the command line.
+    std::string shard{"0/1"};
+
+    //!\brief The 0-based index of the shard to sketch. Parsed from `shard`.
+    size_t shard_index{0u};
+
+    //!\brief The number of shards the data file is split into. Parsed from `shard`.
+    size_t number_of_shards{1u};
+
+    //!\brief Assign lines to shards by a hash of their filenames instead of splitting into contiguous blocks.
+    bool shard_by_hash{false};
+
+    //!\brief The sketch files of all shards that should be merged into a single sketch file.
+    std::vector<std::filesystem::path> sketch_files{};
     //!\}
 
     /*!\name Statistics configuration
@@ -68,6 +110,123 @@ struct configuration
 
     //!\brief Whether to print verbose output when computing the statistics when computing the layout.
     bool output_verbose_statistics{false};
+
+    /*!\brief How to weigh the expected query cost against the memory when determining the best tmax.
+     * \details
+     * Layouts are compared by `query_cost^w * memory^(1-w)`, both relative to tmax = 64.
+     * 1 only considers the query cost, 0 only the memory.
+     */
+    double query_cost_weight{1.0};
+
+    //!\brief A query cost table written by `chopper calibrate` that replaces the built-in one.
+    std::filesystem::path query_cost_table{};
+
+    //!\brief The query cost factors in use. The built-in ones or, if given, those read from #query_cost_table.
+    layout::ibf_query_cost query_cost{};
+
+    /*!\brief A sample of expected queries (sequence file or `.minimiser` file).
+     * \details
+     * If given, the expected query cost of a layout weights each user bin by the estimated number of k-mers it shares
+     * with the sample, instead of by its k-mer count.
+     */
+    std::filesystem::path query_sample{};
+
+    /*!\brief The maximum number of levels of the layout. 0 means no limit.
+     * \details
+     * Each level adds an IBF lookup to a query. If a layout has more levels, a larger tmax is used instead.
+     */
+    size_t max_levels{0u};
+
+    //!\brief The maximum size of the index, given as e.g. "400G" on the command line. Empty means no limit.
+    std::string max_index_size{};
+
+    //!\brief The maximum size of the index in bytes. Parsed from `max_index_size`. 0 means no limit.
+    size_t max_index_size_in_bytes{0u};
+    //!\}
+
+    /*!\name Divide-and-conquer layout
+     * \{
+     */
+    //!\brief If there are more user bins, they are divided into groups of at most this many user bins. 0 disables it.
+    size_t group_size{0u};
+
+    //!\brief The memory available for the layout DP, given as e.g. "64G" on the command line. Empty means no limit.
+    std::string max_memory{};
+
+    /*!\brief The memory available for the layout DP in bytes. Parsed from `max_memory`. 0 means no limit.
+     * \details
+     * If the DP of all user bins needs more memory, the user bins are divided into groups (see `group_size`).
+     */
+    size_t max_memory_in_bytes{0u};
+
+    /*!\brief The number of independent layouts to divide the user bins into.
+     * \see chopper::layout::partition_user_bins
+     */
+    size_t number_of_partitions{1u};
+
+    //!\brief The similarities of the user bins, if known (see chopper::sketch::similarity_store). May be null.
+    std::shared_ptr<sketch::similarity_store const> similarities{};
+    //!\}
+
+    /*!\name Refinement of the layout
+     * \{
+     */
+    /*!\brief The time in seconds to refine the top-level IBF of the layout after the DP algorithm. 0 disables it.
+     * \see chopper::layout::refine_layout
+     */
+    double refinement_time{0.0};
+    //!\}
+
+    /*!\name Relayout
+     * \{
+     */
+    /*!\brief A layout of a previous run. Empty disables it.
+     * \details
+     * If given, user bins keep their technical bins of the previous layout if this costs less than the new layout.
+     * \see chopper::layout::stabilize_layout
+     */
+    std::filesystem::path previous_layout{};
+
+    //!\brief The cost of rebuilding the whole index, as a fraction of the index size. See `previous_layout`.
+    double move_penalty{0.2};
+    //!\}
+
+    /*!\name Calibration of the query cost (`chopper calibrate`)
+     * \{
+     */
+    //!\brief The FPRs to measure the query cost for. Defaults to the FPRs of the built-in table.
+    std::vector<double> calibration_fprs{};
+
+    //!\brief The largest number of technical bins to measure. Larger t_max are extrapolated.
+    size_t calibration_max_tmax{4096u};
+
+    //!\brief The number of elements inserted into each technical bin.
+    size_t calibration_elements{10000u};
+
+    //!\brief The number of queries per measurement.
+    size_t calibration_queries{1000u};
+
+    //!\brief Each measurement is repeated this many times and the fastest run is kept.
+    size_t calibration_repetitions{3u};
+    //!\}
+
+    /*!\name Parameter sweep (`chopper sweep`)
+     * \{
+     */
+    //!\brief The maximum false positive rates to lay out with. Empty means the default of the HIBF config.
+    std::vector<double> sweep_fprs{};
+
+    //!\brief The relaxed false positive rates to lay out with. Empty means the default of the HIBF config.
+    std::vector<double> sweep_relaxed_fprs{};
+
+    //!\brief The numbers of hash functions to lay out with. Empty means the default of the HIBF config.
+    std::vector<size_t> sweep_hash_functions{};
+
+    //!\brief The alpha values to lay out with. Empty means the default of the HIBF config.
+    std::vector<double> sweep_alphas{};
+
+    //!\brief The numbers of technical bins to lay out with. Empty means the default of the HIBF config.
+    std::vector<size_t> sweep_tmaxs{};
     //!\}
 
     //!\brief The HIBF config which will be used to compute the layout within the HIBF lib.
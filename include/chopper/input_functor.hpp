@@ -9,16 +9,32 @@
 
 #include <cinttypes>
 #include <cstddef>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <seqan3/io/sequence_file/all.hpp>
 
 #include <hibf/config.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
 
 namespace chopper
 {
 
+/*!\brief The filenames of each user bin, shared by all consumers instead of copied.
+ * \details
+ * The filenames cannot be modified through the store. Copying the store, e.g. when copying an input_functor or a
+ * configuration, only copies a pointer.
+ */
+using filename_store = std::shared_ptr<std::vector<std::vector<std::string>> const>;
+
+//!\brief Moves `filenames` into a filename_store.
+inline filename_store make_filename_store(std::vector<std::vector<std::string>> filenames)
+{
+    return std::make_shared<std::vector<std::vector<std::string>> const>(std::move(filenames));
+}
+
 struct input_functor
 {
     struct dna4_traits : public seqan3::sequence_file_input_default_traits_dna
@@ -31,7 +47,8 @@ struct input_functor
                                     seqan3::fields<seqan3::field::seq>,
                                     seqan3::type_list<seqan3::format_fasta, seqan3::format_fastq>>;
 
-    std::vector<std::vector<std::string>> filenames;
+    //!\brief The filenames of each user bin. Shared, because the functor is copied with the HIBF config.
+    filename_store filenames;
 
     bool input_are_precomputed_files{false};
 
@@ -39,7 +56,16 @@ struct input_functor
 
     uint8_t window_size{21};
 
+    //!\brief Inserts the hash values of all files of user bin `num`.
     void operator()(size_t const num, seqan::hibf::insert_iterator it);
+
+    //!\brief Adds the hash values of a single file to `sketch`.
+    void add_to_sketch(std::string const & filename, seqan::hibf::sketch::hyperloglog & sketch) const;
+
+private:
+    //!\brief Calls `on_hash` for every hash value of `filename`.
+    template <typename on_hash_t>
+    void for_each_hash(std::string const & filename, on_hash_t && on_hash) const;
 };
 
 } // namespace chopper
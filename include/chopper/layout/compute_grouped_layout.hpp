@@ -0,0 +1,91 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+
+#include <hibf/config.hpp>
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+//!\brief The estimated number of bytes the DP matrices of one IBF take per technical bin and user bin.
+inline constexpr size_t dp_bytes_per_cell{32u};
+
+//!\brief Estimates the memory of the DP matrices of seqan::hibf::layout::compute_layout for a single IBF.
+[[nodiscard]] inline constexpr size_t estimate_dp_memory(size_t const tmax, size_t const number_of_user_bins)
+{
+    return dp_bytes_per_cell * tmax * number_of_user_bins;
+}
+
+/*!\brief Returns the largest number of user bins per group that respects `config.group_size` and
+ *        `config.max_memory_in_bytes`.
+ * \details
+ * If all `number_of_user_bins` fit into a single layout, the result is at least `number_of_user_bins`.
+ * The memory of each group is estimated by estimate_dp_memory(); `hibf_config.threads` groups are computed at once.
+ * \throws std::invalid_argument if not even a single user bin fits into the memory limit.
+ */
+size_t group_size_within_memory(configuration const & config,
+                                seqan::hibf::config const & hibf_config,
+                                size_t const number_of_user_bins);
+
+/*!\brief Splits the user bins `positions` into groups of at most `group_size` user bins.
+ * \param[in] config The configuration. `config.similarities` is used if it is set.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] positions The user bins to group.
+ * \param[in] group_size The maximum number of user bins per group.
+ * \details
+ * There are `ceil(positions.size() / group_size)` groups whose sizes differ by at most one. Each group starts
+ * with the largest user bin that is not yet grouped. If the similarities are known (see
+ * chopper::sketch::similarity_store), the group is filled with the most similar user bins of its members first;
+ * otherwise, and if these are exhausted, with the next largest user bins.
+ */
+std::vector<std::vector<size_t>> group_user_bins(configuration const & config,
+                                                 std::vector<size_t> const & kmer_counts,
+                                                 std::vector<size_t> const & positions,
+                                                 size_t const group_size);
+
+/*!\brief Returns the groups compute_grouped_layout() divides the user bins `positions` into.
+ * \param[in] config The configuration. `config.similarities` is used if it is set.
+ * \param[in] hibf_config The HIBF configuration to compute the layout with, e.g. with a reduced `tmax`.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] positions The user bins to group.
+ * \details
+ * These are the groups of group_user_bins(). If the user bins do not need to be grouped, i.e. all fit into one group
+ * (see group_size_within_memory()), the result is empty.
+ */
+std::vector<std::vector<size_t>> divide_into_groups(configuration const & config,
+                                                    seqan::hibf::config const & hibf_config,
+                                                    std::vector<size_t> const & kmer_counts,
+                                                    std::vector<size_t> const & positions);
+
+/*!\brief Computes the layout of the user bins `positions`, divided into groups if there are many.
+ * \param[in] config The configuration.
+ * \param[in] hibf_config The HIBF configuration to compute the layout with, e.g. with a reduced `tmax`.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] sketches The sketch of each user bin.
+ * \param[in] positions The user bins to lay out.
+ * \details
+ * If the user bins do not need to be grouped (see divide_into_groups()), this is seqan::hibf::layout::compute_layout.
+ * Otherwise, the layout of each group is computed independently (in parallel with `hibf_config.threads` threads),
+ * and each group becomes a merged bin of the top-level IBF.
+ * The result is a valid layout with one more level than the layouts of the groups.
+ * \throws std::invalid_argument if there are more groups than `hibf_config.tmax` technical bins.
+ */
+seqan::hibf::layout::layout compute_grouped_layout(configuration const & config,
+                                                   seqan::hibf::config const & hibf_config,
+                                                   std::vector<size_t> const & kmer_counts,
+                                                   std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                                   std::vector<size_t> positions);
+
+} // namespace chopper::layout
@@ -0,0 +1,60 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+/*!\brief Computes a layout in which all user bins with a priority greater than 0 are split bins on the top level.
+ * \param[in] config The configuration. `config.hibf_config.tmax` is the number of technical bins on the top level.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] sketches The sketch of each user bin.
+ * \param[in] priorities The priority of each user bin (see chopper::sketch::read_data_file). May be empty.
+ * \details
+ * Each pinned user bin is split into as many technical bins as its share of all k-mers on `tmax` technical bins,
+ * but at least one. The remaining user bins are laid out by compute_grouped_layout on the remaining
+ * technical bins, which are placed in front of the pinned ones. Note that the remaining layout also uses the
+ * reduced number of technical bins on its lower levels.
+ * If no user bin is pinned, this is the same as compute_grouped_layout.
+ * \throws std::invalid_argument if the pinned user bins do not leave any technical bins for the remaining ones.
+ */
+seqan::hibf::layout::layout
+compute_layout_with_pinned_bins(configuration const & config,
+                                std::vector<size_t> const & kmer_counts,
+                                std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                std::vector<size_t> const & priorities);
+
+/*!\brief Returns the groups compute_layout_with_pinned_bins() divides the user bins that are not pinned into.
+ * \details
+ * See divide_into_groups(). The groups are those of the technical bins that the pinned user bins leave. The result
+ * is empty if the user bins are not grouped.
+ */
+std::vector<std::vector<size_t>> divide_unpinned_into_groups(configuration const & config,
+                                                             std::vector<size_t> const & kmer_counts,
+                                                             std::vector<size_t> const & priorities);
+
+/*!\brief Computes a layout with a single level, i.e. every user bin is a split bin on the top level.
+ * \param[in] config The configuration. `config.hibf_config.tmax` is the number of technical bins on the top level.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \details
+ * Every user bin gets one technical bin. The remaining technical bins go to the user bins with the most k-mers per
+ * technical bin. Used if the layout algorithm needs more levels than allowed (see configuration::max_levels).
+ * \throws std::invalid_argument if there are fewer technical bins than user bins.
+ */
+seqan::hibf::layout::layout compute_single_level_layout(configuration const & config,
+                                                        std::vector<size_t> const & kmer_counts);
+
+} // namespace chopper::layout
@@ -0,0 +1,35 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+/*!\brief Returns the best layout with the lowest FPR whose index fits into `config.max_index_size_in_bytes`.
+ * \details
+ * The FPR is chosen by a binary search over a fixed set of FPRs between 0.0001 and 0.3. For each FPR, the number of
+ * hash functions that minimises the size of a Bloom filter is used, the relaxed FPR is raised to at least the FPR, and
+ * the best t_max is determined by determine_best_number_of_technical_bins. The size of a layout is estimated by
+ * hibf_statistics::total_hibf_size_in_byte. The sketches are reused for all FPRs.
+ * `config.hibf_config` is set to the parameters of the returned layout.
+ * \throws no_layout_within_limits if not even the highest FPR yields a layout that fits.
+ */
+seqan::hibf::layout::layout determine_best_fpr(chopper::configuration & config,
+                                               std::vector<size_t> const & kmer_counts,
+                                               std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                               std::vector<size_t> const & priorities = {});
+
+} // namespace chopper::layout
@@ -5,6 +5,9 @@
 // shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
 // ---------------------------------------------------------------------------------------------------
 
+#pragma once
+
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -16,9 +19,23 @@
 namespace chopper::layout
 {
 
+//!\brief Thrown if no layout satisfies `--max-levels` and `--max-index-size`.
+struct no_layout_within_limits : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+/*!\brief Computes the layouts for t_max = 64, 128, ..., tmax and sqrt(#user bins) and returns the best one.
+ * \details
+ * The statistics of all layouts are written to `config.output_filename` + ".stats". Layouts with more than
+ * `config.max_levels` levels or larger than `config.max_index_size_in_bytes` are not selected.
+ * `config.hibf_config.tmax` is set to the t_max of the returned layout.
+ * \throws no_layout_within_limits if no layout satisfies the limits.
+ */
 seqan::hibf::layout::layout
 determine_best_number_of_technical_bins(chopper::configuration & config,
                                         std::vector<size_t> const & kmer_counts,
-                                        std::vector<seqan::hibf::sketch::hyperloglog> const & sketches);
+                                        std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                        std::vector<size_t> const & priorities = {});
 
 }
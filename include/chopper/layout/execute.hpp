@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -17,8 +18,16 @@
 namespace chopper::layout
 {
 
+/*!\brief Computes the layout and writes it to `config.output_filename`.
+ * \details
+ * User bins with a priority greater than 0 are pinned to the top level (see compute_layout_with_pinned_bins).
+ * `priorities` may be empty if no user bin has a priority.
+ * With `config.number_of_partitions` > 1, the user bins are divided by partition_user_bins and the layout of each
+ * partition is written to partition_layout_path(config.output_filename, partition).
+ */
 int execute(chopper::configuration & config,
             std::vector<std::vector<std::string>> const & filenames,
-            std::vector<seqan::hibf::sketch::hyperloglog> const & sketches);
+            std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+            std::vector<size_t> const & priorities = {});
 
 } // namespace chopper::layout
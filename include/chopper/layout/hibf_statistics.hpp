@@ -93,6 +93,77 @@ public:
     //!\brief Prints a tab-separated summary of the statistics of this HIBF to the command line.
     void print_summary_to(size_t & t_max_64_memory, std::ostream & stream, bool const verbose = true);
 
+    /*!\brief Prints the expected query cost of the pinned user bins compared to that of all user bins.
+     * \param[in] priorities The priority of each user bin. User bins with a priority greater than 0 are pinned.
+     * \param[in] stream The stream to print to.
+     * \details
+     * Both costs are weighted the same way, i.e. by the query_weights or, if there are none, by the k-mer counts.
+     * Nothing is printed if no user bin is pinned. finalize() must have been called.
+     */
+    void print_pinned_summary_to(std::vector<size_t> const & priorities, std::ostream & stream) const;
+
+    /*!\brief Prints how much memory limiting the number of levels (`--max-levels`) costs.
+     * \param[in] stream The stream to print to.
+     * \param[in] max_levels The maximum number of levels.
+     * \param[in] t_max The t_max of the layout that respects the limit.
+     * \param[in] size The total size in bytes of the layout that respects the limit.
+     * \param[in] unlimited_t_max The t_max of the layout without the limit.
+     * \param[in] unlimited_size The total size in bytes of the layout without the limit.
+     */
+    static void print_level_limit_summary_to(std::ostream & stream,
+                                             size_t const max_levels,
+                                             size_t const t_max,
+                                             size_t const size,
+                                             size_t const unlimited_t_max,
+                                             size_t const unlimited_size);
+
+    /*!\brief Prints into how many groups the user bins are divided (`--group-size`, `--max-memory`) and how large
+     *        these groups are.
+     * \param[in] stream The stream to print to.
+     * \param[in] groups The user bins of each group (see divide_into_groups()).
+     */
+    static void print_grouping_to(std::ostream & stream, std::vector<std::vector<size_t>> const & groups);
+
+    /*!\brief Prints how a layout divided into groups (see print_grouping_to()) compares to a single layout of all
+     *        user bins.
+     * \param[in] stream The stream to print to.
+     * \param[in] size The total size in bytes of the grouped layout.
+     * \param[in] query_cost The expected query cost of the grouped layout.
+     * \param[in] monolithic_size The total size in bytes of the single layout.
+     * \param[in] monolithic_query_cost The expected query cost of the single layout.
+     */
+    static void print_grouped_summary_to(std::ostream & stream,
+                                         size_t const size,
+                                         double const query_cost,
+                                         size_t const monolithic_size,
+                                         double const monolithic_query_cost);
+
+    /*!\brief Prints what the refinement of the layout (`--refinement-time`) changed.
+     * \param[in] stream The stream to print to.
+     * \param[in] moves The number of changes that were kept.
+     * \param[in] max_bin_size_before The corrected size of the largest top-level technical bin before the refinement.
+     * \param[in] max_bin_size_after The corrected size of the largest top-level technical bin after the refinement.
+     */
+    static void print_refinement_summary_to(std::ostream & stream,
+                                            size_t const moves,
+                                            double const max_bin_size_before,
+                                            double const max_bin_size_after);
+
+    /*!\brief Prints whether the layout carried over from `--previous-layout` was kept (see stabilize_layout).
+     * \param[in] stream The stream to print to.
+     * \param[in] kept_previous Whether the carried over layout was kept.
+     * \param[in] size The total size in bytes of the chosen layout.
+     * \param[in] rebuilt_fraction The fraction of the chosen layout that must be rebuilt.
+     * \param[in] alternative_size The total size in bytes of the other layout. 0 if there is none.
+     * \param[in] alternative_rebuilt_fraction The fraction of the other layout that must be rebuilt.
+     */
+    static void print_stability_summary_to(std::ostream & stream,
+                                           bool const kept_previous,
+                                           size_t const size,
+                                           double const rebuilt_fraction,
+                                           size_t const alternative_size,
+                                           double const alternative_rebuilt_fraction);
+
     //!\brief Return the total corrected size of the HIBF in bytes
     size_t total_hibf_size_in_byte();
 
@@ -108,11 +179,24 @@ public:
     //!\brief The estimated query cost relative to the total k-mer count in the data set.
     double expected_HIBF_query_cost{0.0};
 
+    //!\brief The estimated query cost of each user bin, i.e. the cost of querying all IBFs on its path.
+    std::vector<double> user_bin_query_costs{};
+
     //!\brief A reference to the input counts.
     seqan::hibf::layout::layout hibf_layout;
 
+    /*!\brief How often each user bin is expected to be hit by a query (see chopper::sketch::estimate_query_hits).
+     * \details
+     * If empty, every k-mer of the input is assumed to be queried equally often, i.e., the expected query cost weights
+     * each user bin by its k-mer count. Must be set before calling finalize().
+     */
+    std::vector<double> query_weights{};
+
 private:
-    //!\brief Copy of the user configuration for this HIBF.
+    /*!\brief Copy of the user configuration for this HIBF.
+     * \details
+     * The copy is cheap: the input functor only shares the filenames (see chopper::filename_store).
+     */
     configuration const config{};
 
     //!\brief The split bin false positive correction factors to use for the statistics.
@@ -11,26 +11,78 @@
 #include <bit>
 #include <cassert>
 #include <cstddef>
+#include <filesystem>
+#include <iosfwd>
 #include <map>
+#include <utility>
 
 namespace chopper::layout
 {
 
+/*!\brief The cost of querying an IBF with t_max technical bins relative to an IBF with 64 technical bins.
+ * \details
+ * A default-constructed ibf_query_cost uses the built-in table. A table measured by `chopper calibrate` can be
+ * loaded with read_from() and is passed on as part of the chopper::configuration.
+ */
 class ibf_query_cost
 {
 public:
     static inline constexpr const size_t maximum_t_max{65536};
 
-    ibf_query_cost() = default;
+    //!\brief The number of t_max values per FPR in the table: 64, 128, ..., 65536.
+    static inline constexpr const size_t number_of_t_max_values{11};
+
+    //!\brief The cost factors of a single FPR for all t_max values.
+    using factors_type = std::array<double, number_of_t_max_values>;
+
+    //!\brief Maps an FPR to the cost factors for all t_max values.
+    using table_type = std::map<double, factors_type>;
+
+    //!\brief Uses the built-in cost factors.
+    ibf_query_cost() : cost_factors{built_in_cost_factors.begin(), built_in_cost_factors.end()}
+    {}
+
     ibf_query_cost(ibf_query_cost const &) = default;
     ibf_query_cost & operator=(ibf_query_cost const &) = default;
     ibf_query_cost(ibf_query_cost &&) = default;
     ibf_query_cost & operator=(ibf_query_cost &&) = default;
     ~ibf_query_cost() = default;
 
-    static double exact(size_t const t_max, double const fpr);
+    /*!\brief Uses the cost factors in `table`.
+     * \throws std::invalid_argument if `table` is empty.
+     */
+    explicit ibf_query_cost(table_type table);
+
+    double exact(size_t const t_max, double const fpr) const;
+
+    /*!\brief The cost factor for any t_max and FPR.
+     * \details
+     * Between the measured t_max, the cost factor is interpolated linearly. Beyond #maximum_t_max, the cost factor is
+     * extrapolated with the power law given by the last two measured t_max.
+     * Between the measured FPRs, the cost factor is interpolated linearly in log(FPR). FPRs outside the measured range
+     * use the closest measured FPR.
+     */
+    double interpolated(size_t const t_max, double const fpr) const;
+
+    /*!\brief Reads a table from `stream`, e.g. written by `chopper calibrate`.
+     * \details
+     * Lines starting with '#' are ignored. Every other line contains an FPR followed by the
+     * #number_of_t_max_values cost factors for t_max = 64, 128, ..., 65536, separated by tabs.
+     * \throws std::invalid_argument if the table is malformed.
+     */
+    static ibf_query_cost read_from(std::istream & stream);
+
+    //!\brief Reads the table in `path`. See read_from().
+    static ibf_query_cost read_from(std::filesystem::path const & path);
+
+    //!\brief Writes `table` in the format expected by read_from().
+    static void write_to(std::ostream & stream, table_type const & table);
 
-    static double interpolated(size_t const t_max, double const fpr);
+    //!\brief The cost factors that are used.
+    table_type const & table() const
+    {
+        return cost_factors;
+    }
 
 private:
     /*!\brief The cost factor to penalize a search in an IBF with more then 64 bins.
@@ -42,9 +94,9 @@ private:
      * Each run was conducted 5 times and the mean was taken over the measurements. Low FPR rates were observed to have
      * a rather high variance on the runs.
      *
-     * See also `test/benchmark/benchmark_data/query_cost`.
+     * See also `test/benchmark/benchmark_data/query_cost`. `chopper calibrate` measures a table on the local machine.
      */
-    static inline const std::map<double, std::array<double, 11>> cost_factors{
+    static constexpr std::array<std::pair<double, factors_type>, 7> built_in_cost_factors{{
         /* FPR, cost factors relative to a 64 IBF */
         {0.0001, {1.0000, 1.0602, 1.3492, 1.3524, 1.5645, 1.9595, 3.4143, 5.4849, 6.8115, 10.9489, 19.8932}},
         {0.0005, {1.0000, 1.0534, 1.1068, 1.2821, 1.5151, 1.7112, 3.6442, 4.7700, 6.9978, 12.2086, 22.5374}},
@@ -52,9 +104,15 @@ private:
         {0.0125, {1.0000, 1.0071, 1.1713, 1.3430, 1.8335, 2.6955, 5.3925, 8.6168, 15.0510, 28.3340, 54.4134}},
         {0.0500, {1.0000, 1.2241, 1.3336, 1.6827, 2.4608, 3.7554, 7.3573, 12.4689, 23.2699, 45.0874, 86.5339}},
         {0.0625, {1.0000, 1.1011, 1.2670, 1.5964, 2.4030, 3.6996, 7.1772, 12.4852, 23.3882, 44.7427, 87.8259}},
-        {0.3125, {1.0000, 1.2818, 1.5493, 2.2546, 3.7804, 6.5428, 12.9410, 24.4539, 47.6262, 93.4733, 185.1019}}};
+        {0.3125, {1.0000, 1.2818, 1.5493, 2.2546, 3.7804, 6.5428, 12.9410, 24.4539, 47.6262, 93.4733, 185.1019}}}};
+
+    //!\brief The cost factors in use. Either the built-in ones or those read by read_from().
+    table_type cost_factors;
+
+    table_type::const_iterator find_closest_fpr(double const fpr) const;
 
-    static std::map<double, std::array<double, 11>>::const_iterator find_closest_fpr(double const fpr);
+    //!\brief Interpolates (or extrapolates) the cost factors of a single FPR for `t_max`.
+    static double interpolated(factors_type const & factors, size_t const t_max);
 
     static constexpr bool contains(size_t const value)
     {
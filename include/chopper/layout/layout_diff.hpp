@@ -0,0 +1,92 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <hibf/layout/layout.hpp>
+
+namespace chopper::layout
+{
+
+//!\brief The differences between a previous and a new layout. See diff_layouts().
+struct layout_diff
+{
+    //!\brief An IBF of the new layout that does not occur in the previous layout and must be rebuilt.
+    struct changed_ibf
+    {
+        //!\brief The technical bins on the path to the IBF. Empty for the top-level IBF.
+        std::vector<size_t> previous_TB_indices{};
+
+        //!\brief The number of user bins stored in the IBF.
+        size_t user_bins{};
+
+        //!\brief The number of k-mers inserted into the IBF.
+        size_t kmers{};
+    };
+
+    //!\brief The number of IBFs of the new layout.
+    size_t number_of_ibfs{};
+
+    //!\brief The IBFs of the new layout that must be rebuilt, sorted by their path.
+    std::vector<changed_ibf> changed_ibfs{};
+
+    //!\brief The number of user bins of both layouts that are stored in different technical bins.
+    size_t moved_user_bins{};
+
+    //!\brief The number of user bins that are only in the new layout.
+    size_t added_user_bins{};
+
+    //!\brief The number of user bins that are only in the previous layout.
+    size_t removed_user_bins{};
+
+    //!\brief The number of k-mers inserted into the changed IBFs, i.e. the cost of rebuilding them.
+    size_t rebuilt_kmers{};
+
+    //!\brief The number of k-mers inserted into all IBFs, i.e. the cost of building the new layout from scratch.
+    size_t total_kmers{};
+
+    //!\brief The fraction of the build cost of the new layout that is spent on rebuilding the changed IBFs.
+    double rebuilt_fraction() const
+    {
+        return total_kmers > 0u ? static_cast<double>(rebuilt_kmers) / total_kmers : 0.0;
+    }
+};
+
+//!\brief Identifies a user bin across layouts by its filenames.
+std::string user_bin_key(std::vector<std::string> const & filenames);
+
+/*!\brief Compares a new layout to a previous layout and determines which IBFs must be rebuilt.
+ * \param[in] previous_filenames The filenames of the user bins of the previous layout.
+ * \param[in] previous_layout The previous layout.
+ * \param[in] filenames The filenames of the user bins of the new layout.
+ * \param[in] hibf_layout The new layout.
+ * \param[in] kmer_counts The k-mer count of each user bin of the new layout. If empty, each user bin counts as one
+ *                        k-mer.
+ * \details
+ * User bins are identified by their filenames. An IBF of the new layout can be reused if the previous layout has an IBF
+ * that stores the same user bins in the same technical bins, regardless of where this IBF is in the hierarchy. All
+ * other IBFs must be rebuilt. Files are assumed to be unchanged; an IBF that stores a changed file must be rebuilt as
+ * well.
+ */
+layout_diff diff_layouts(std::vector<std::vector<std::string>> const & previous_filenames,
+                         seqan::hibf::layout::layout const & previous_layout,
+                         std::vector<std::vector<std::string>> const & filenames,
+                         seqan::hibf::layout::layout const & hibf_layout,
+                         std::vector<size_t> const & kmer_counts);
+
+/*!\brief Writes a summary of `diff` and a tab-separated table of the changed IBFs to `stream`.
+ * \details
+ * IBFs are named as in the header of a layout file, e.g. `HIGH_LEVEL_IBF` or `MERGED_BIN_2;5`.
+ */
+void write_layout_diff_to(std::ostream & stream, layout_diff const & diff);
+
+} // namespace chopper::layout
@@ -0,0 +1,31 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include <hibf/layout/layout.hpp>
+
+namespace chopper::layout
+{
+
+/*!\brief Returns the number of levels of `hibf_layout`, i.e. the number of IBFs queried on the longest path.
+ * \param[in] hibf_layout The layout.
+ */
+[[nodiscard]] inline size_t number_of_levels(seqan::hibf::layout::layout const & hibf_layout)
+{
+    size_t levels{1u};
+
+    for (auto const & user_bin : hibf_layout.user_bins)
+        levels = std::max(levels, user_bin.previous_TB_indices.size() + 1u);
+
+    return levels;
+}
+
+} // namespace chopper::layout
@@ -0,0 +1,77 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+//!\brief The number of times the partitions are rebalanced by their predicted index size.
+inline constexpr size_t partition_balancing_rounds{3u};
+
+//!\brief Returns the elements of `values` at `indices`. If `values` is empty, the result is empty.
+template <typename value_t>
+std::vector<value_t> select_user_bins(std::vector<value_t> const & values, std::vector<size_t> const & indices)
+{
+    std::vector<value_t> result{};
+
+    if (values.empty())
+        return result;
+
+    result.reserve(indices.size());
+    for (size_t const idx : indices)
+        result.push_back(values[idx]);
+
+    return result;
+}
+
+//!\brief Returns the path of the layout file of partition `partition`, e.g. "layout.2.txt" for "layout.txt".
+std::filesystem::path partition_layout_path(std::filesystem::path const & output_filename, size_t const partition);
+
+/*!\brief Returns the configuration to lay out the user bins `user_bins` of a single partition.
+ * \details
+ * The result writes to `partition_layout_path(config.output_filename, partition)`, keeps the FPRs of `user_bins`
+ * and uses the strictest of them (see use_strictest_fpr()), and does not use the similarities of all user bins.
+ */
+configuration partition_configuration(configuration const & config,
+                                      size_t const partition,
+                                      std::vector<size_t> const & user_bins);
+
+/*!\brief Splits the user bins into (at least) `config.number_of_partitions` partitions with similar predicted sizes.
+ * \param[in] config The configuration. `config.similarities` is used if it is set.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] sketches The sketch of each user bin.
+ * \param[in] priorities The priority of each user bin. May be empty.
+ * \returns The user bins of each partition, sorted by their index.
+ * \details
+ * The user bins are ordered such that similar user bins are next to each other (see group_user_bins). This order is
+ * cut into contiguous partitions with equal weights. At first, the weight of a user bin is its k-mer count. Then, the
+ * layout of each partition is computed, and its size is predicted by hibf_statistics::total_hibf_size_in_byte. The
+ * weight of a user bin becomes its k-mer count times the predicted bytes per k-mer of its partition, and the order is
+ * cut again. Of these partition_balancing_rounds rounds, the partitions whose largest predicted size is smallest are
+ * returned.
+ *
+ * User bins with different FPRs (see fpr_classes()) are never in the same partition, such that each partition is
+ * sized at the FPR of its user bins. Each FPR class gets one partition, and the remaining partitions go to the
+ * classes with the most k-mers per partition. Hence, there are more than `config.number_of_partitions` partitions if
+ * there are more FPR classes.
+ * \throws std::invalid_argument if there are fewer user bins than partitions.
+ */
+std::vector<std::vector<size_t>> partition_user_bins(configuration const & config,
+                                                     std::vector<size_t> const & kmer_counts,
+                                                     std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                                     std::vector<size_t> const & priorities);
+
+} // namespace chopper::layout
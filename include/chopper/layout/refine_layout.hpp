@@ -0,0 +1,58 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+//!\brief The outcome of refine_layout().
+struct refinement_result
+{
+    //!\brief The number of changes that were kept.
+    size_t moves{};
+
+    //!\brief The corrected size of the largest top-level technical bin before the refinement.
+    double max_bin_size_before{};
+
+    //!\brief The corrected size of the largest top-level technical bin after the refinement.
+    double max_bin_size_after{};
+};
+
+/*!\brief Improves the top-level IBF of a layout computed by the DP algorithm by local changes.
+ * \param[in] config The configuration. The refinement stops after `config.refinement_time` seconds.
+ * \param[in,out] hibf_layout The layout to refine.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] sketches The sketch of each user bin.
+ * \param[in] priorities The priority of each user bin (see chopper::sketch::read_data_file). May be empty.
+ * \details
+ * The memory of an IBF is its largest technical bin times its number of technical bins. The refinement repeatedly
+ * tries to shrink the largest top-level technical bin:
+ * * If it is a merged bin, a user bin directly below it is moved into the lower-level IBF of another merged bin.
+ *   The sizes of both merged bins are estimated by the union of the HyperLogLog sketches of their user bins.
+ * * If it is a split bin, it gets one more technical bin, taken from another split bin or from the unused technical
+ *   bins of the top-level IBF. Pinned user bins (priority greater than 0) never give away technical bins.
+ *
+ * The best change is kept if it reduces the memory of the top-level IBF. Technical bin ids and the maximum bins of
+ * the affected lower-level IBFs are updated such that the result is a valid layout. Lower-level IBFs are not refined
+ * themselves.
+ */
+refinement_result refine_layout(configuration const & config,
+                                seqan::hibf::layout::layout & hibf_layout,
+                                std::vector<size_t> const & kmer_counts,
+                                std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                std::vector<size_t> const & priorities);
+
+} // namespace chopper::layout
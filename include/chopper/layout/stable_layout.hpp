@@ -0,0 +1,105 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+/*!\brief Recomputes the maximum technical bin of every IBF of `hibf_layout`.
+ * \param[in] config The configuration.
+ * \param[in,out] hibf_layout The layout.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] sketches The sketch of each user bin.
+ * \details
+ * Split bins are compared by their corrected k-mer count and merged bins by the union of the sketches of their user
+ * bins, as in the layout algorithm.
+ */
+void update_max_bins(configuration const & config,
+                     seqan::hibf::layout::layout & hibf_layout,
+                     std::vector<size_t> const & kmer_counts,
+                     std::vector<seqan::hibf::sketch::hyperloglog> const & sketches);
+
+/*!\brief Places the user bins as in a previous layout, such that the IBFs of the previous index can be reused.
+ * \param[in] config The configuration.
+ * \param[in] previous_filenames The filenames of the user bins of the previous layout.
+ * \param[in] previous_layout The previous layout.
+ * \param[in] filenames The filenames of the user bins.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] sketches The sketch of each user bin.
+ * \param[in] priorities The priority of each user bin (see compute_layout_with_pinned_bins). May be empty.
+ * \details
+ * User bins are identified by their filenames. User bins of the previous layout keep their technical bins and removed
+ * user bins leave their technical bins empty. Each new user bin gets an unused technical bin of the top-level IBF.
+ * If there is none, it is added to the lower-level IBF of the merged bin whose union grows the least by the new user
+ * bin. If that IBF has no unused technical bin either, the split bin that suffers the least gives up its last technical
+ * bin. As a last resort, a split bin of the top-level IBF gives up a technical bin. Pinned user bins keep their
+ * technical bins. The maximum bins of all IBFs are recomputed.
+ *
+ * Returns std::nullopt if two user bins of either layout have the same filenames, an IBF of the previous layout has
+ * more than `config.hibf_config.tmax` technical bins, a pinned user bin was in a merged bin, or there is no technical
+ * bin left for a new user bin.
+ */
+std::optional<seqan::hibf::layout::layout>
+carry_over_layout(configuration const & config,
+                  std::vector<std::vector<std::string>> const & previous_filenames,
+                  seqan::hibf::layout::layout const & previous_layout,
+                  std::vector<std::vector<std::string>> const & filenames,
+                  std::vector<size_t> const & kmer_counts,
+                  std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                  std::vector<size_t> const & priorities);
+
+//!\brief The outcome of stabilize_layout().
+struct stabilization_result
+{
+    //!\brief Whether the layout carried over from the previous layout was kept.
+    bool kept_previous{};
+
+    //!\brief The size in bytes of the chosen layout.
+    size_t size{};
+
+    //!\brief The fraction of the chosen layout that must be rebuilt (see layout_diff::rebuilt_fraction).
+    double rebuilt_fraction{};
+
+    //!\brief The size in bytes of the other layout. 0 if the previous layout could not be carried over.
+    size_t alternative_size{};
+
+    //!\brief The fraction of the other layout that must be rebuilt.
+    double alternative_rebuilt_fraction{};
+};
+
+/*!\brief Replaces `hibf_layout` by the layout carried over from `config.previous_layout` if it costs less.
+ * \param[in] config The configuration.
+ * \param[in,out] hibf_layout The layout computed by the layout algorithm.
+ * \param[in] filenames The filenames of the user bins.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] sketches The sketch of each user bin.
+ * \param[in] priorities The priority of each user bin. May be empty.
+ * \details
+ * The cost of a layout is its size times `1 + config.move_penalty * r`, where `r` is the fraction of the layout that
+ * must be rebuilt compared to the previous layout (see diff_layouts). The previous layout is carried over with
+ * carry_over_layout().
+ * \throws std::runtime_error if the previous layout cannot be read.
+ */
+stabilization_result stabilize_layout(configuration const & config,
+                                      seqan::hibf::layout::layout & hibf_layout,
+                                      std::vector<std::vector<std::string>> const & filenames,
+                                      std::vector<size_t> const & kmer_counts,
+                                      std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                      std::vector<size_t> const & priorities);
+
+} // namespace chopper::layout
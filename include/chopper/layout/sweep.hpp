@@ -0,0 +1,55 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+//!\brief The parameters and the resulting statistics of one layout of a parameter sweep.
+struct sweep_result
+{
+    double fpr{};                 //!< The maximum false positive rate.
+    double relaxed_fpr{};         //!< The relaxed false positive rate.
+    size_t hash_functions{};      //!< The number of hash functions.
+    double alpha{};               //!< The alpha value of the DP algorithm.
+    size_t tmax{};                //!< The number of technical bins of the top-level IBF.
+    bool valid{false};            //!< Whether a layout could be computed with these parameters.
+    size_t levels{};              //!< The number of levels of the layout.
+    size_t size_in_bytes{};       //!< The estimated size of the index.
+    double expected_query_cost{}; //!< The expected query cost relative to a single IBF with tmax = 64.
+};
+
+/*!\brief Computes a layout for every combination of the parameters `config.sweep_*`.
+ * \param[in] config The configuration. Empty parameter lists use the value of `config.hibf_config`.
+ * \param[in] kmer_counts The k-mer count of each user bin.
+ * \param[in] sketches The sketch of each user bin.
+ * \param[in] priorities The priority of each user bin (see chopper::sketch::read_data_file). May be empty.
+ * \details
+ * The k-mer counts and sketches are shared by all combinations, the sketches are packed only once for the
+ * statistics. The combinations are laid out in parallel with `config.hibf_config.threads` threads, each with a single
+ * thread. The results are in the order of the nested loops over FPR, relaxed FPR, hash functions, alpha and tmax,
+ * independent of the number of threads. Combinations that are not valid, e.g. with a relaxed FPR lower than the FPR,
+ * are reported with `valid == false`.
+ */
+std::vector<sweep_result> sweep(configuration const & config,
+                                std::vector<size_t> const & kmer_counts,
+                                std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                std::vector<size_t> const & priorities = {});
+
+//!\brief Writes the results of sweep() as a tab-separated table with a header line.
+void write_sweep_table_to(std::ostream & stream, std::vector<sweep_result> const & results);
+
+} // namespace chopper::layout
@@ -0,0 +1,45 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+
+namespace chopper::layout
+{
+
+/*!\brief The FPR of the user bin `idx`.
+ * \details
+ * This is the FPR given in the data file (see configuration::user_bin_fprs) or, if there is none,
+ * `config.hibf_config.maximum_fpr`.
+ */
+[[nodiscard]] inline double user_bin_fpr(configuration const & config, size_t const idx)
+{
+    return idx < config.user_bin_fprs.size() && config.user_bin_fprs[idx] > 0.0 ? config.user_bin_fprs[idx]
+                                                                                 : config.hibf_config.maximum_fpr;
+}
+
+/*!\brief Sets `config.hibf_config.maximum_fpr` to the strictest FPR of the `config.hibf_config.number_of_user_bins`
+ *        user bins (see user_bin_fpr()).
+ * \details
+ * The HIBF builds every IBF with `maximum_fpr`, which is written to the layout file. With the strictest FPR, each
+ * user bin gets at most its own FPR, and the size estimates of chopper match the index that is built.
+ */
+void use_strictest_fpr(configuration & config);
+
+/*!\brief Divides the `config.hibf_config.number_of_user_bins` user bins by their FPR (see user_bin_fpr()).
+ * \details
+ * Each class holds the indices of the user bins with the same FPR in ascending order. The classes are ordered from
+ * the strictest FPR to the most relaxed one. Since all IBFs of a layout share one FPR, only separate layouts give
+ * each class its own FPR (see partition_user_bins()).
+ */
+[[nodiscard]] std::vector<std::vector<size_t>> fpr_classes(configuration const & config);
+
+} // namespace chopper::layout
@@ -16,4 +16,12 @@ namespace chopper
 
 void set_up_parser(sharg::parser & parser, configuration & config);
 
+void set_up_sketch_parser(sharg::parser & parser, configuration & config);
+
+void set_up_merge_sketches_parser(sharg::parser & parser, configuration & config);
+
+void set_up_calibrate_parser(sharg::parser & parser, configuration & config);
+
+void set_up_sweep_parser(sharg::parser & parser, configuration & config);
+
 }
@@ -0,0 +1,29 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+/*!\brief Computes one HyperLogLog sketch per user bin.
+ * \details
+ * `config.hibf_config.input_fn` must hold a chopper::input_functor.
+ * In contrast to seqan::hibf::sketch::compute_sketches, every file of a user bin is sketched on its own task.
+ * The files of all user bins are scheduled together on `config.hibf_config.threads` threads and the sketches of the
+ * files are merged into the sketch of their user bin. Since merging sketches is order-independent, the result is the
+ * same as sketching each user bin sequentially.
+ * The sketches are stored sparse, so their memory scales with the size of the user bins (see sparse_hyperloglog).
+ */
+void compute_sketches(configuration const & config, std::vector<sparse_hyperloglog> & sketches);
+
+} // namespace chopper::sketch
@@ -0,0 +1,29 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+#include <chopper/configuration.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+/*!\brief Estimates for every user bin how many k-mers of the query sample it contains.
+ * \details
+ * The query sample `config.query_sample` is sketched with the k-mer and window size of the user bins. A `.minimiser`
+ * file is read as precomputed hashes. The number of hits of a user bin is the size of the intersection of its sketch
+ * and the sample sketch, i.e., |sample| + |user bin| - |sample ∪ user bin|.
+ * \throws std::runtime_error if the query sample does not share any k-mers with the user bins.
+ */
+std::vector<double> estimate_query_hits(configuration const & config,
+                                        std::vector<seqan::hibf::sketch::hyperloglog> const & sketches);
+
+} // namespace chopper::sketch
@@ -0,0 +1,82 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+/*!\brief Returns the registers of `sketch`, one byte per register.
+ * \details
+ * seqan::hibf::sketch::hyperloglog has no public access to its registers. They are read from its serialised form,
+ * which is the number of bits followed by all registers. This is the only place that relies on this format;
+ * hyperloglog_registers_test pins it.
+ */
+std::vector<uint8_t> registers_of(seqan::hibf::sketch::hyperloglog const & sketch);
+
+//!\brief Returns the sketch with the given registers. The number of registers must be a power of two.
+seqan::hibf::sketch::hyperloglog to_hyperloglog(std::vector<uint8_t> const & registers);
+
+/*!\brief Computes the HyperLogLog estimate of registers that are not stored in a seqan::hibf::sketch::hyperloglog.
+ * \details
+ * Add all registers of a sketch, then call estimate(). The estimate is that of seqan::hibf::sketch::hyperloglog up
+ * to floating point rounding.
+ */
+class hyperloglog_estimator
+{
+public:
+    //!\brief An estimator for a sketch with `number_of_registers` registers, which must be a power of two.
+    explicit hyperloglog_estimator(size_t const number_of_registers) noexcept;
+
+    //!\brief Adds a register with the given value.
+    void add(uint8_t const value) noexcept
+    {
+        sum += inverse_powers_of_two[value & 63u];
+        zeros += value == 0u;
+    }
+
+    //!\brief Adds `count` registers with the given value, e.g. all zero registers of a sparse sketch at once.
+    void add(uint8_t const value, size_t const count) noexcept
+    {
+        sum += inverse_powers_of_two[value & 63u] * static_cast<double>(count);
+        zeros += value == 0u ? count : 0u;
+    }
+
+    //!\brief The estimated number of distinct values of all added registers.
+    double estimate() const noexcept;
+
+private:
+    //!\brief 2^-value for every value a register can have.
+    static constexpr std::array<double, 64> inverse_powers_of_two = []()
+    {
+        std::array<double, 64> result{};
+        for (size_t value = 0; value < result.size(); ++value)
+            result[value] = 1.0 / static_cast<double>(1ULL << value);
+        return result;
+    }();
+
+    //!\brief The number of registers of the sketch.
+    size_t number_of_registers{};
+
+    //!\brief alpha * m^2 of the HyperLogLog estimate.
+    double normalization_factor{};
+
+    //!\brief The sum of 2^-value over all added registers.
+    double sum{};
+
+    //!\brief The number of added registers with value 0.
+    size_t zeros{};
+};
+
+} // namespace chopper::sketch
@@ -0,0 +1,43 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+//!\brief The default number of registers per band of lsh_candidate_pairs().
+inline constexpr size_t default_rows_per_band{12u};
+
+/*!\brief Returns pairs of user bins that are likely similar, found by locality-sensitive hashing of their sketches.
+ * \param[in] sketches The sketch of each user bin. All sketches must have the same number of registers.
+ * \param[in] rows_per_band The number of registers per band.
+ * \param[in] threads The number of threads to use.
+ * \returns The candidate pairs `(i, j)` with `i < j`, sorted and without duplicates.
+ * \details
+ * Register `r` of a HyperLogLog sketch is the maximum rank of all values that fall into bucket `r`. Two sketches have
+ * the same register if the value of maximum rank of the union is in the intersection, i.e. with a probability of at
+ * least the Jaccard index, which makes a register a coarse MinHash value. The registers are divided into bands of
+ * `rows_per_band` registers, and two user bins become a candidate pair if all registers of at least one band are equal.
+ * Bands that only contain empty registers are ignored.
+ *
+ * Each band is sorted by the hash of its registers, so the runtime is `O(bands * n log n)` instead of the `O(n^2)` of
+ * comparing all pairs. More rows per band find fewer, but more similar, pairs. Within a very large bucket, each user
+ * bin is only paired with the following user bins of the bucket, which still connects all of them.
+ */
+std::vector<std::pair<size_t, size_t>>
+lsh_candidate_pairs(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                    size_t const rows_per_band = default_rows_per_band,
+                    size_t const threads = 1u);
+
+} // namespace chopper::sketch
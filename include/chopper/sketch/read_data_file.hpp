@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,44 @@
 namespace chopper::sketch
 {
 
-void read_data_file(configuration const & config, std::vector<std::vector<std::string>> & filenames);
+//!\brief The user bins read from a data file (see read_data_file()). All members have one entry per user bin.
+struct data_file_content
+{
+    //!\brief The filenames of each user bin.
+    std::vector<std::vector<std::string>> filenames{};
+
+    /*!\brief The 0-based line index of each user bin.
+     * \details
+     * The line index is the global user bin index, i.e. the position of the user bin in the complete data file.
+     */
+    std::vector<size_t> user_bin_indices{};
+
+    /*!\brief The priority of each user bin, given by a field `priority=<number>`. The default is 0.
+     * \details
+     * User bins with a priority greater than 0 are pinned to the top level of the layout
+     * (see chopper::layout::compute_layout_with_pinned_bins).
+     */
+    std::vector<size_t> priorities{};
+
+    /*!\brief The FPR of each user bin, given by a field `fpr=<number>`.
+     * \details
+     * The default is 0, i.e. the FPR of the HIBF config (see chopper::layout::user_bin_fpr).
+     */
+    std::vector<double> fprs{};
+};
+
+/*!\brief Reads the user bins from `config.data_file`.
+ * \details
+ * Each line of the data file describes one user bin. Multiple files of a user bin are separated by a space.
+ * The filenames of a line may be followed by tab-separated auxiliary fields (see data_file_content). Other fields are
+ * ignored.
+ *
+ * If `config.number_of_shards` is greater than 1, only the lines of shard `config.shard_index` are read.
+ * A shard is either a contiguous block of lines or, if `config.shard_by_hash` is set, all lines whose filenames
+ * hash to the shard. Both are deterministic: the same data file always yields the same shards.
+ * \throws std::runtime_error if the file cannot be opened, a priority is not a non-negative integer or an FPR is not
+ *         in (0, 1).
+ */
+[[nodiscard]] data_file_content read_data_file(configuration const & config);
 
 } // namespace chopper::sketch
@@ -0,0 +1,184 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <filesystem>
+#include <iosfwd>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <cereal/cereal.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+/*!\brief Stores the most similar user bins of each user bin.
+ * \details
+ * The similarity of two user bins is the Jaccard index estimated from their HyperLogLog sketches, i.e.
+ * (|A| + |B| - |A ∪ B|) / |A ∪ B|. Computing it for all pairs is quadratic in the number of user bins. For many user
+ * bins, it is only computed for the candidate pairs of lsh_candidate_pairs(). The store keeps only the
+ * `neighbours_per_user_bin` most similar user bins with a similarity greater than 0 and can be written next to the
+ * sketch file (see similarity_store_path()) such that later runs can load it instead of recomputing it.
+ * The store records the number of bits of the sketches and a checksum of their registers, such that a store that
+ * was computed from other sketches is not used (see was_computed_from()).
+ */
+class similarity_store
+{
+public:
+    //!\brief A similar user bin.
+    struct neighbour
+    {
+        uint64_t index{};      //!< The index of the similar user bin.
+        float similarity{};    //!< The estimated Jaccard index.
+
+        bool operator==(neighbour const &) const = default;
+
+        template <typename archive_t>
+        void serialize(archive_t & archive)
+        {
+            archive(index, similarity);
+        }
+    };
+
+    //!\brief Up to this many user bins, all pairs are compared. For more user bins, only candidate pairs are compared.
+    static constexpr size_t max_user_bins_for_all_pairs{4096u};
+
+    //!\brief The number of neighbours per user bin if the store is only needed to group the user bins.
+    static constexpr size_t default_neighbours_per_user_bin{16u};
+
+    similarity_store() = default;
+    similarity_store(similarity_store const &) = default;
+    similarity_store & operator=(similarity_store const &) = default;
+    similarity_store(similarity_store &&) = default;
+    similarity_store & operator=(similarity_store &&) = default;
+    ~similarity_store() = default;
+
+    /*!\brief Computes the `neighbours_per_user_bin` most similar user bins of each user bin.
+     * \param[in] sketches The sketch of each user bin.
+     * \param[in] neighbours_per_user_bin The maximum number of neighbours stored per user bin.
+     * \param[in] threads The number of threads to use.
+     * \details
+     * Up to max_user_bins_for_all_pairs user bins, all pairs are compared. Otherwise, only the candidate pairs of
+     * lsh_candidate_pairs() are compared, which may miss neighbours with a low similarity.
+     * The neighbours of a user bin are sorted by decreasing similarity, ties by increasing index. The result does not
+     * depend on the number of threads.
+     */
+    similarity_store(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                     size_t const neighbours_per_user_bin,
+                     size_t const threads = 1u);
+
+    /*!\brief Computes the `neighbours_per_user_bin` most similar user bins of each user bin among `candidates`.
+     * \param[in] sketches The sketch of each user bin.
+     * \param[in] candidates The pairs of user bins to compare, e.g. from lsh_candidate_pairs().
+     * \param[in] neighbours_per_user_bin The maximum number of neighbours stored per user bin.
+     * \param[in] threads The number of threads to use.
+     */
+    similarity_store(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                     std::vector<std::pair<size_t, size_t>> const & candidates,
+                     size_t const neighbours_per_user_bin,
+                     size_t const threads = 1u);
+
+    //!\brief The number of user bins.
+    size_t size() const
+    {
+        return offsets.empty() ? 0u : offsets.size() - 1u;
+    }
+
+    //!\brief The maximum number of neighbours per user bin.
+    size_t neighbours_per_user_bin() const
+    {
+        return max_neighbours;
+    }
+
+    //!\brief Whether the store was computed from `sketches`, i.e. the same user bins and the same sketch parameters.
+    bool was_computed_from(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches) const;
+
+    //!\brief The neighbours of user bin `idx`, sorted by decreasing similarity.
+    std::span<neighbour const> neighbours(size_t const idx) const
+    {
+        return std::span<neighbour const>{entries.data() + offsets[idx], entries.data() + offsets[idx + 1u]};
+    }
+
+    //!\brief Writes the store in binary format to `stream`.
+    void write_to(std::ostream & stream) const;
+
+    //!\brief Reads a store written by write_to() from `stream`.
+    void read_from(std::istream & stream);
+
+private:
+    friend class cereal::access;
+
+    //!\brief The maximum number of neighbours per user bin.
+    size_t max_neighbours{};
+
+    //!\brief The number of bits of the sketches the store was computed from.
+    uint8_t sketch_bits{};
+
+    //!\brief A checksum of the registers of all sketches the store was computed from.
+    uint64_t sketch_checksum{};
+
+    //!\brief The neighbours of user bin `i` are `entries[offsets[i]]` to `entries[offsets[i + 1] - 1]`.
+    std::vector<size_t> offsets{};
+
+    //!\brief The neighbours of all user bins.
+    std::vector<neighbour> entries{};
+
+    /*!\brief Computes the neighbours of each user bin.
+     * \param[in] sketches The sketch of each user bin.
+     * \param[in] candidates_of The user bins to compare each user bin with. If null, all user bins are compared.
+     * \param[in] threads The number of threads to use.
+     */
+    void compute_neighbours(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                            std::vector<std::vector<size_t>> const * const candidates_of,
+                            size_t const threads);
+
+    template <typename archive_t>
+    void serialize(archive_t & archive)
+    {
+        uint32_t version{2};
+        archive(CEREAL_NVP(version));
+
+        // Stores of version 1 carry no sketch parameters. They are read as empty stores and hence recomputed.
+        if (version != 2u)
+            return;
+
+        archive(CEREAL_NVP(max_neighbours));
+        archive(CEREAL_NVP(sketch_bits));
+        archive(CEREAL_NVP(sketch_checksum));
+        archive(CEREAL_NVP(offsets));
+        archive(CEREAL_NVP(entries));
+    }
+};
+
+//!\brief Returns the path of the similarity store that belongs to `sketch_file`, e.g. "all.similarities".
+inline std::filesystem::path similarity_store_path(std::filesystem::path const & sketch_file)
+{
+    return std::filesystem::path{sketch_file}.replace_extension(".similarities");
+}
+
+//!\brief Computes the similarity store of `sketches` and writes it to similarity_store_path(sketch_file).
+void write_similarity_store_next_to(std::filesystem::path const & sketch_file,
+                                    std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                    size_t const neighbours_per_user_bin,
+                                    size_t const threads);
+
+/*!\brief Reads the similarity store at similarity_store_path(sketch_file).
+ * \returns The store, or std::nullopt if there is no store or it was not computed from `sketches`.
+ */
+std::optional<similarity_store>
+read_similarity_store_next_to(std::filesystem::path const & sketch_file,
+                              std::vector<seqan::hibf::sketch::hyperloglog> const & sketches);
+
+} // namespace chopper::sketch
@@ -7,11 +7,15 @@
 
 #pragma once
 
+#include <cstddef>
+#include <filesystem>
+#include <string>
 #include <vector>
 
 #include <cereal/types/vector.hpp>
 
 #include <chopper/configuration.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
 
 #include <hibf/sketch/hyperloglog.hpp>
 #include <hibf/sketch/minhashes.hpp>
@@ -23,23 +27,79 @@ struct sketch_file
 {
     chopper::configuration chopper_config{};
     std::vector<std::vector<std::string>> filenames{};
-    std::vector<seqan::hibf::sketch::hyperloglog> hll_sketches{};
+    std::vector<sparse_hyperloglog> hll_sketches{};
     std::vector<seqan::hibf::sketch::minhashes> minHash_sketches{};
 
+    //!\brief The 0-based index of the shard this file holds (see `chopper sketch --shard`).
+    size_t shard_index{0u};
+
+    //!\brief The number of shards of the data file. A sketch file of the whole data file has exactly one shard.
+    size_t number_of_shards{1u};
+
+    /*!\brief The global user bin index (line in the data file) of each entry in `filenames` and `hll_sketches`.
+     * \details
+     * May be empty if the file holds all user bins in the order of the data file.
+     */
+    std::vector<size_t> user_bin_indices{};
+
+    /*!\brief The priority of each entry in `filenames` (see chopper::sketch::read_data_file).
+     * \details
+     * May be empty if no user bin has a priority.
+     */
+    std::vector<size_t> priorities{};
+
+    /*!\brief The FPR of each entry in `filenames` (see chopper::sketch::read_data_file).
+     * \details
+     * May be empty if no user bin has an FPR.
+     */
+    std::vector<double> fprs{};
+
 private:
     friend class cereal::access;
 
     template <typename archive_t>
     void serialize(archive_t & archive)
     {
-        uint32_t version{1};
+        uint32_t version{6};
         archive(CEREAL_NVP(version));
 
         archive(CEREAL_NVP(chopper_config));
         archive(CEREAL_NVP(filenames));
-        archive(CEREAL_NVP(hll_sketches));
+
+        if (version >= 4u)
+        {
+            archive(CEREAL_NVP(hll_sketches));
+        }
+        else // Version 3 and older stored dense sketches.
+        {
+            std::vector<seqan::hibf::sketch::hyperloglog> dense_sketches{};
+            archive(CEREAL_NVP(dense_sketches));
+            hll_sketches = to_sparse_sketches(dense_sketches);
+        }
+
         archive(CEREAL_NVP(minHash_sketches));
+
+        if (version >= 2u) // Version 1 did not support shards.
+        {
+            archive(CEREAL_NVP(shard_index));
+            archive(CEREAL_NVP(number_of_shards));
+        }
+
+        if (version >= 3u) // Version 2 only supported contiguous shards.
+            archive(CEREAL_NVP(user_bin_indices));
+
+        if (version >= 5u) // Version 4 did not support priorities.
+            archive(CEREAL_NVP(priorities));
+
+        if (version >= 6u) // Version 5 did not support FPRs per user bin.
+            archive(CEREAL_NVP(fprs));
     }
 };
 
+//!\brief Returns whether `path` has the extension of a sketch file, i.e. ".sketch" or ".sketches".
+inline bool has_sketch_file_extension(std::filesystem::path const & path)
+{
+    return path.string().ends_with(".sketch") || path.string().ends_with(".sketches");
+}
+
 } // namespace chopper::sketch
@@ -0,0 +1,107 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+#include <cereal/types/vector.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+/*!\brief A HyperLogLog sketch that only stores its non-zero registers as long as there are few of them.
+ * \details
+ * A seqan::hibf::sketch::hyperloglog always holds 2^bits registers, no matter how many values were added.
+ * For small user bins, most registers are zero. This sketch stores the non-zero registers as a sorted list and
+ * switches to a dense array of registers once the list would use more memory than the dense array.
+ *
+ * Converting to and from seqan::hibf::sketch::hyperloglog is lossless.
+ */
+class sparse_hyperloglog
+{
+public:
+    sparse_hyperloglog() = default;
+    sparse_hyperloglog(sparse_hyperloglog const &) = default;
+    sparse_hyperloglog & operator=(sparse_hyperloglog const &) = default;
+    sparse_hyperloglog(sparse_hyperloglog &&) = default;
+    sparse_hyperloglog & operator=(sparse_hyperloglog &&) = default;
+    ~sparse_hyperloglog() = default;
+
+    //!\brief An empty sketch with 2^num_bits registers.
+    explicit sparse_hyperloglog(uint8_t const num_bits) : bits{num_bits}
+    {}
+
+    //!\brief Compresses the given sketch.
+    explicit sparse_hyperloglog(seqan::hibf::sketch::hyperloglog const & sketch);
+
+    //!\brief Returns the equivalent seqan::hibf::sketch::hyperloglog.
+    seqan::hibf::sketch::hyperloglog to_hyperloglog() const;
+
+    //!\brief Merges `other` into this sketch. Both sketches must have the same number of registers.
+    void merge(sparse_hyperloglog const & other);
+
+    /*!\brief Estimates the number of distinct values directly from the stored registers.
+     * \details
+     * Equal to the estimate of the dense sketch up to floating point rounding (see hyperloglog_estimator).
+     */
+    double estimate() const;
+
+    //!\brief The number of registers, i.e. 2^bits.
+    size_t data_size() const
+    {
+        return size_t{1u} << bits;
+    }
+
+    //!\brief Whether only the non-zero registers are stored.
+    bool is_sparse() const
+    {
+        return dense_registers.empty();
+    }
+
+    //!\brief The number of bytes used to store the registers.
+    size_t memory_usage() const
+    {
+        return sparse_registers.size() * sizeof(uint64_t) + dense_registers.size();
+    }
+
+    template <typename archive_t>
+    void serialize(archive_t & archive)
+    {
+        archive(bits);
+        archive(sparse_registers);
+        archive(dense_registers);
+    }
+
+private:
+    //!\brief The number of bits used to address a register.
+    uint8_t bits{};
+
+    //!\brief The non-zero registers, encoded as `(index << 8) | value` and sorted by index. Empty if dense.
+    std::vector<uint64_t> sparse_registers{};
+
+    //!\brief All registers. Empty if sparse.
+    std::vector<uint8_t> dense_registers{};
+
+    //!\brief Switches to the sparse representation if it uses less memory, and to the dense one otherwise.
+    void choose_representation();
+};
+
+//!\brief Compresses all sketches.
+std::vector<sparse_hyperloglog> to_sparse_sketches(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches);
+
+//!\brief Decompresses all sketches, e.g. for the layout algorithm that requires seqan::hibf::sketch::hyperloglog.
+std::vector<seqan::hibf::sketch::hyperloglog> to_dense_sketches(std::vector<sparse_hyperloglog> const & sketches);
+
+//!\brief Decompresses all sketches and frees each compressed sketch as soon as it is decompressed.
+std::vector<seqan::hibf::sketch::hyperloglog> to_dense_sketches(std::vector<sparse_hyperloglog> && sketches);
+
+} // namespace chopper::sketch
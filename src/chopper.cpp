@@ -5,23 +5,62 @@
 // shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
 // ---------------------------------------------------------------------------------------------------
 
+#include <string_view>
+
+#include <chopper/chopper_calibrate.hpp>
 #include <chopper/chopper_layout.hpp>
+#include <chopper/chopper_merge_sketches.hpp>
+#include <chopper/chopper_sketch.hpp>
+#include <chopper/chopper_sweep.hpp>
 #include <chopper/set_up_parser.hpp>
 
 int main(int argc, char const * argv[])
 {
-    sharg::parser parser{"chopper", argc, argv, sharg::update_notifications::off};
-    parser.info.version = "1.0.0";
-
-    chopper::configuration config;
-    set_up_parser(parser, config);
-    parser.info.synopsis.front().insert(0, "chopper");
+    // `chopper sketch`, `chopper merge-sketches` and `chopper layout` are separate steps that can be scheduled
+    // independently. Calling `chopper` without a subcommand computes sketches and layout in one go, as before.
+    std::string_view const subcommand{argc > 1 ? argv[1] : ""};
 
     int exit_code{};
+    chopper::configuration config;
 
     try
     {
-        exit_code = chopper::chopper_layout(config, parser);
+        if (subcommand == "sketch")
+        {
+            sharg::parser parser{"chopper-sketch", argc - 1, argv + 1, sharg::update_notifications::off};
+            set_up_sketch_parser(parser, config);
+            exit_code = chopper::chopper_sketch(config, parser);
+        }
+        else if (subcommand == "merge-sketches")
+        {
+            sharg::parser parser{"chopper-merge-sketches", argc - 1, argv + 1, sharg::update_notifications::off};
+            set_up_merge_sketches_parser(parser, config);
+            exit_code = chopper::chopper_merge_sketches(config, parser);
+        }
+        else if (subcommand == "calibrate")
+        {
+            sharg::parser parser{"chopper-calibrate", argc - 1, argv + 1, sharg::update_notifications::off};
+            set_up_calibrate_parser(parser, config);
+            exit_code = chopper::chopper_calibrate(config, parser);
+        }
+        else if (subcommand == "sweep")
+        {
+            sharg::parser parser{"chopper-sweep", argc - 1, argv + 1, sharg::update_notifications::off};
+            set_up_sweep_parser(parser, config);
+            exit_code = chopper::chopper_sweep(config, parser);
+        }
+        else
+        {
+            bool const is_layout_subcommand{subcommand == "layout"};
+            sharg::parser parser{is_layout_subcommand ? "chopper-layout" : "chopper",
+                                 argc - is_layout_subcommand,
+                                 argv + is_layout_subcommand,
+                                 sharg::update_notifications::off};
+            parser.info.version = "1.0.0";
+            set_up_parser(parser, config);
+            parser.info.synopsis.front().insert(0, is_layout_subcommand ? "chopper layout" : "chopper");
+            exit_code = chopper::chopper_layout(config, parser);
+        }
     }
     catch (std::exception const & ext)
     {
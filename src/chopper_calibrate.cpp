@@ -0,0 +1,137 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cinttypes>
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sharg/parser.hpp>
+
+#include <chopper/chopper_calibrate.hpp>
+#include <chopper/configuration.hpp>
+#include <chopper/layout/ibf_query_cost.hpp>
+
+#include <hibf/build/bin_size_in_bits.hpp>
+#include <hibf/interleaved_bloom_filter.hpp>
+#include <hibf/misc/timer.hpp>
+
+namespace chopper
+{
+
+//!\brief The number of hashes per query. Roughly the number of minimisers of a short read.
+static constexpr size_t hashes_per_query{128u};
+
+//!\brief Returns the fastest time (in seconds) of answering all queries with an IBF of `t_max` technical bins.
+static double measure_query_time(chopper::configuration const & config,
+                                 size_t const t_max,
+                                 double const fpr,
+                                 std::vector<std::vector<uint64_t>> const & queries)
+{
+    size_t const hash_count{config.hibf_config.number_of_hash_functions};
+    size_t const bin_size{seqan::hibf::build::bin_size_in_bits(
+        {.fpr = fpr, .hash_count = hash_count, .elements = config.calibration_elements})};
+
+    seqan::hibf::interleaved_bloom_filter ibf{seqan::hibf::bin_count{t_max},
+                                              seqan::hibf::bin_size{bin_size},
+                                              seqan::hibf::hash_function_count{hash_count}};
+
+    // The fill level of the bins, not their content, determines the query time.
+    std::mt19937_64 engine{t_max};
+    for (size_t bin = 0; bin < t_max; ++bin)
+        for (size_t i = 0; i < config.calibration_elements; ++i)
+            ibf.emplace(engine(), seqan::hibf::bin_index{bin});
+
+    auto agent = ibf.counting_agent<uint16_t>();
+    double fastest{std::numeric_limits<double>::max()};
+    volatile size_t sink{};
+
+    for (size_t repetition = 0; repetition < config.calibration_repetitions; ++repetition)
+    {
+        seqan::hibf::serial_timer timer{};
+        timer.start();
+        for (auto const & query : queries)
+            sink = sink + agent.bulk_count(query)[0];
+        timer.stop();
+        fastest = std::min(fastest, timer.in_seconds());
+    }
+
+    return fastest;
+}
+
+chopper::layout::ibf_query_cost::table_type calibrate_query_cost(chopper::configuration const & config)
+{
+    using chopper::layout::ibf_query_cost;
+
+    std::vector<double> fprs{config.calibration_fprs};
+    if (fprs.empty())
+        for (auto const & [fpr, factors] : config.query_cost.table())
+            fprs.push_back(fpr);
+
+    std::mt19937_64 engine{0u};
+    std::vector<std::vector<uint64_t>> queries(config.calibration_queries, std::vector<uint64_t>(hashes_per_query));
+    for (auto & query : queries)
+        std::ranges::generate(query, engine);
+
+    ibf_query_cost::table_type table{};
+
+    for (double const fpr : fprs)
+    {
+        ibf_query_cost::factors_type factors{};
+        double const baseline{measure_query_time(config, 64u, fpr, queries)};
+        factors[0] = 1.0;
+
+        size_t t_max{128u};
+        size_t position{1u};
+        // A measurement may be faster than that of a smaller t_max by chance. The table must not decrease.
+        for (; t_max <= config.calibration_max_tmax; t_max <<= 1, ++position)
+            factors[position] =
+                std::max(measure_query_time(config, t_max, fpr, queries) / baseline, factors[position - 1]);
+
+        // Not measured: Continue with the growth of the configured (by default the built-in) table.
+        for (; position < factors.size(); t_max <<= 1, ++position)
+            factors[position] = factors[position - 1] * config.query_cost.exact(t_max, fpr)
+                              / config.query_cost.exact(t_max >> 1, fpr);
+
+        table.emplace(fpr, factors);
+    }
+
+    return table;
+}
+
+int chopper_calibrate(chopper::configuration & config, sharg::parser & parser)
+{
+    parser.parse();
+
+    if (!std::has_single_bit(config.calibration_max_tmax) || config.calibration_max_tmax < 64u
+        || config.calibration_max_tmax > chopper::layout::ibf_query_cost::maximum_t_max)
+        throw sharg::parser_error{"The --max-tmax must be a power of two in [64, "
+                                  + std::to_string(chopper::layout::ibf_query_cost::maximum_t_max) + "]."};
+
+    for (double const fpr : config.calibration_fprs)
+        if (fpr <= 0.0 || fpr >= 1.0)
+            throw sharg::parser_error{"The --fpr values must be in (0, 1)."};
+
+    auto const table = calibrate_query_cost(config);
+
+    std::ofstream output_stream{config.query_cost_table};
+    output_stream << "# Query cost table computed by chopper calibrate with " << config.calibration_elements
+                  << " elements per bin, " << config.hibf_config.number_of_hash_functions
+                  << " hash functions and t_max up to " << config.calibration_max_tmax << " measured.\n";
+    chopper::layout::ibf_query_cost::write_to(output_stream, table);
+
+    return 0;
+}
+
+} // namespace chopper
@@ -5,11 +5,17 @@
 // shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
 // ---------------------------------------------------------------------------------------------------
 
+#include <charconv>
+#include <cmath>
 #include <exception>
 #include <filesystem>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 #include <sharg/parser.hpp>
@@ -17,13 +23,19 @@
 #include <chopper/chopper_layout.hpp>
 #include <chopper/configuration.hpp>
 #include <chopper/input_functor.hpp>
+#include <chopper/layout/compute_grouped_layout.hpp>
 #include <chopper/layout/execute.hpp>
+#include <chopper/layout/ibf_query_cost.hpp>
+#include <chopper/layout/user_bin_fpr.hpp>
 #include <chopper/sketch/check_filenames.hpp>
+#include <chopper/sketch/compute_sketches.hpp>
 #include <chopper/sketch/output.hpp>
 #include <chopper/sketch/read_data_file.hpp>
+#include <chopper/sketch/similarity_store.hpp>
 #include <chopper/sketch/sketch_file.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
 
-#include <hibf/sketch/compute_sketches.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
 
 namespace chopper
 {
@@ -69,6 +81,35 @@ void validate_configuration(sharg::parser & parser,
     }
 }
 
+/*!\brief Parses a size in bytes like "400G", "1.5TiB" or "1000000" given to `option`.
+ *
+ * The units K, M, G, T and P are powers of 1024 and may be followed by "iB" or "B".
+ */
+size_t parse_byte_size(std::string const & size_string, std::string const & option)
+{
+    std::string_view const size{size_string};
+    double value{};
+    auto const [ptr, error] = std::from_chars(size.data(), size.data() + size.size(), value);
+    std::string_view unit{ptr, static_cast<size_t>(size.data() + size.size() - ptr)};
+
+    if (unit.ends_with("iB"))
+        unit.remove_suffix(2u);
+    else if (unit.ends_with('B'))
+        unit.remove_suffix(1u);
+
+    static constexpr std::string_view units{"KMGTP"};
+    size_t const unit_pos{unit.empty() ? std::string_view::npos : units.find(unit[0])};
+
+    bool const valid_unit = unit.empty() || (unit.size() == 1u && unit_pos != std::string_view::npos);
+
+    if (error != std::errc{} || value <= 0.0 || !valid_unit)
+        throw sharg::parser_error{"The " + option + " must be a positive number, optionally followed by one of the "
+                                  + "units K, M, G, T, P (e.g. \"400G\"), but is \"" + size_string + "\"."};
+
+    double const factor{unit.empty() ? 1.0 : std::ldexp(1.0, 10 * (unit_pos + 1u))};
+    return static_cast<size_t>(value * factor);
+}
+
 int chopper_layout(chopper::configuration & config, sharg::parser & parser)
 {
     parser.parse();
@@ -78,21 +119,33 @@ int chopper_layout(chopper::configuration & config, sharg::parser & parser)
     else if (config.k > config.window_size)
         throw sharg::parser_error{"The k-mer size cannot be bigger than the window size."};
 
-    auto has_sketch_file_extension = [](std::filesystem::path const & path)
-    {
-        return path.string().ends_with(".sketch") || path.string().ends_with(".sketches");
-    };
+    if (parser.is_option_set("max-index-size"))
+        config.max_index_size_in_bytes = parse_byte_size(config.max_index_size, "--max-index-size");
+
+    if (parser.is_option_set("max-memory"))
+        config.max_memory_in_bytes = parse_byte_size(config.max_memory, "--max-memory");
+
+    if (parser.is_option_set("query-cost-weight") || parser.is_option_set("query-sample")
+        || parser.is_option_set("max-index-size"))
+        config.determine_best_tmax = true;
+
+    if (!config.previous_layout.empty() && config.number_of_partitions > 1u)
+        throw sharg::parser_error{"--previous-layout cannot be combined with --partitions."};
+
+    if (!config.query_cost_table.empty())
+        config.query_cost = chopper::layout::ibf_query_cost::read_from(config.query_cost_table);
 
     config.disable_sketch_output = !parser.is_option_set("output-sketches-to");
-    if (!config.disable_sketch_output && !has_sketch_file_extension(config.sketch_directory))
+    if (!config.disable_sketch_output && !chopper::sketch::has_sketch_file_extension(config.sketch_directory))
         throw sharg::parser_error{"The sketch output file must have the extension \".sketch\" or \".sketches\"."};
 
-    bool const input_is_a_sketch_file = has_sketch_file_extension(config.data_file);
+    bool const input_is_a_sketch_file = chopper::sketch::has_sketch_file_extension(config.data_file);
 
     int exit_code{};
 
     std::vector<std::vector<std::string>> filenames{};
-    std::vector<seqan::hibf::sketch::hyperloglog> sketches{};
+    std::vector<size_t> priorities{};
+    std::vector<chopper::sketch::sparse_hyperloglog> sparse_sketches{};
 
     if (input_is_a_sketch_file)
     {
@@ -104,13 +157,28 @@ int chopper_layout(chopper::configuration & config, sharg::parser & parser)
             iarchive(sin);
         }
 
+        if (sin.number_of_shards != 1u)
+            throw sharg::parser_error{sharg::detail::to_string("The sketch file ",
+                                                               config.data_file.string(),
+                                                               " only contains shard ",
+                                                               sin.shard_index,
+                                                               '/',
+                                                               sin.number_of_shards,
+                                                               ". Please combine all shards with "
+                                                               "`chopper merge-sketches` first.")};
+
         filenames = std::move(sin.filenames); // No need to call check_filenames because the files are not read.
-        sketches = std::move(sin.hll_sketches);
+        sparse_sketches = std::move(sin.hll_sketches);
+        priorities = std::move(sin.priorities);
+        config.user_bin_fprs = std::move(sin.fprs);
         validate_configuration(parser, config, sin.chopper_config);
     }
     else
     {
-        chopper::sketch::read_data_file(config, filenames);
+        chopper::sketch::data_file_content data{chopper::sketch::read_data_file(config)};
+        filenames = std::move(data.filenames);
+        priorities = std::move(data.priorities);
+        config.user_bin_fprs = std::move(data.fprs);
 
         if (filenames.empty())
             throw sharg::parser_error{
@@ -120,30 +188,80 @@ int chopper_layout(chopper::configuration & config, sharg::parser & parser)
         chopper::sketch::check_filenames(filenames, config);
     }
 
+    if (config.number_of_partitions > filenames.size())
+        throw sharg::parser_error{sharg::detail::to_string("Cannot divide ",
+                                                           filenames.size(),
+                                                           " user bins into ",
+                                                           config.number_of_partitions,
+                                                           " partitions (--partitions).")};
+
+    // The input functor is copied with every configuration. It shares the filenames instead of copying them.
+    auto const shared_filenames = std::make_shared<std::vector<std::vector<std::string>>>(std::move(filenames));
     config.hibf_config.input_fn =
-        chopper::input_functor{filenames, config.precomputed_files, config.k, config.window_size};
-    config.hibf_config.number_of_user_bins = filenames.size();
+        chopper::input_functor{shared_filenames, config.precomputed_files, config.k, config.window_size};
+    config.hibf_config.number_of_user_bins = shared_filenames->size();
     config.hibf_config.validate_and_set_defaults();
 
+    // User bins with different FPRs are laid out in separate partitions (see partition_user_bins).
+    bool const has_several_fprs = chopper::layout::fpr_classes(config).size() > 1u;
+    if (!config.previous_layout.empty() && has_several_fprs)
+        throw sharg::parser_error{"--previous-layout cannot be combined with user bins that have different FPRs."};
+
     if (!input_is_a_sketch_file)
     {
         config.compute_sketches_timer.start();
-        seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+        chopper::sketch::compute_sketches(config, sparse_sketches);
         config.compute_sketches_timer.stop();
     }
 
-    exit_code |= chopper::layout::execute(config, filenames, sketches);
-
+    // The sketch file is written while only the sparse sketches exist. It lends the filenames and priorities.
     if (!config.disable_sketch_output)
     {
         chopper::sketch::sketch_file sout{.chopper_config = config,
-                                          .filenames = std::move(filenames),
-                                          .hll_sketches = std::move(sketches)};
-        std::ofstream os{config.sketch_directory, std::ios::binary};
-        cereal::BinaryOutputArchive oarchive{os};
-        oarchive(sout);
+                                          .filenames = std::move(*shared_filenames),
+                                          .hll_sketches = std::move(sparse_sketches),
+                                          .priorities = std::move(priorities),
+                                          .fprs = config.user_bin_fprs};
+        {
+            std::ofstream os{config.sketch_directory, std::ios::binary};
+            cereal::BinaryOutputArchive oarchive{os};
+            oarchive(sout);
+        }
+
+        *shared_filenames = std::move(sout.filenames);
+        sparse_sketches = std::move(sout.hll_sketches);
+        priorities = std::move(sout.priorities);
     }
 
+    // The layout algorithm works on dense sketches. Each sparse sketch is freed once it is decompressed.
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches =
+        chopper::sketch::to_dense_sketches(std::move(sparse_sketches));
+
+    // Similarities are only needed to group or partition the user bins. A store next to the sketch file is only used
+    // if it was computed from the same sketches. Otherwise, the similarities are estimated from the sketches.
+    if (config.number_of_partitions > 1u || has_several_fprs
+        || chopper::layout::group_size_within_memory(config, config.hibf_config, sketches.size()) < sketches.size())
+    {
+        std::optional<chopper::sketch::similarity_store> similarities =
+            input_is_a_sketch_file ? chopper::sketch::read_similarity_store_next_to(config.data_file, sketches)
+                                   : std::nullopt;
+
+        config.similarities =
+            similarities ? std::make_shared<chopper::sketch::similarity_store const>(std::move(*similarities))
+                         : std::make_shared<chopper::sketch::similarity_store const>(
+                             sketches,
+                             chopper::sketch::similarity_store::default_neighbours_per_user_bin,
+                             config.hibf_config.threads);
+    }
+
+    exit_code |= chopper::layout::execute(config, *shared_filenames, sketches, priorities);
+
+    if (!config.disable_sketch_output && config.similarity_neighbours > 0u)
+        chopper::sketch::write_similarity_store_next_to(config.sketch_directory,
+                                                        sketches,
+                                                        config.similarity_neighbours,
+                                                        config.hibf_config.threads);
+
     if (!config.output_timings.empty())
     {
         std::ofstream output_stream{config.output_timings};
@@ -0,0 +1,220 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <ios>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <sharg/parser.hpp>
+
+#include <chopper/chopper_merge_sketches.hpp>
+#include <chopper/configuration.hpp>
+#include <chopper/sketch/similarity_store.hpp>
+#include <chopper/sketch/sketch_file.hpp>
+
+namespace chopper
+{
+
+/*!\brief Checks that a shard was sketched with the same parameters as the first non-empty shard.
+ *
+ * Sketches can only be combined if they were computed with the same k-mer size, window size and number of sketch bits.
+ * The latter is not part of the chopper configuration and is thus checked via the sketches themselves.
+ */
+void validate_shard(chopper::sketch::sketch_file const & shard,
+                    chopper::sketch::sketch_file const & first_shard,
+                    std::filesystem::path const & shard_filename)
+{
+    auto throw_mismatch = [&shard_filename](char const * parameter, size_t const value, size_t const expected)
+    {
+        throw std::runtime_error{sharg::detail::to_string("The sketch file ",
+                                                          shard_filename.string(),
+                                                          " was computed with a ",
+                                                          parameter,
+                                                          " of ",
+                                                          value,
+                                                          ", but the first non-empty sketch file with a ",
+                                                          parameter,
+                                                          " of ",
+                                                          expected,
+                                                          ". All shards must be sketched with the same parameters.")};
+    };
+
+    if (shard.chopper_config.k != first_shard.chopper_config.k)
+        throw_mismatch("k-mer size", shard.chopper_config.k, first_shard.chopper_config.k);
+
+    if (shard.chopper_config.window_size != first_shard.chopper_config.window_size)
+        throw_mismatch("window size", shard.chopper_config.window_size, first_shard.chopper_config.window_size);
+
+    if (!shard.filenames.empty() && !first_shard.filenames.empty()
+        && shard.chopper_config.precomputed_files != first_shard.chopper_config.precomputed_files)
+        throw std::runtime_error{"The sketch file " + shard_filename.string()
+                                 + " was computed from precomputed minimiser files, but the first non-empty sketch "
+                                   "file was not (or vice versa)."};
+
+    if (!shard.hll_sketches.empty() && !first_shard.hll_sketches.empty()
+        && shard.hll_sketches[0].data_size() != first_shard.hll_sketches[0].data_size())
+        throw_mismatch("number of sketch registers",
+                       shard.hll_sketches[0].data_size(),
+                       first_shard.hll_sketches[0].data_size());
+
+    if (!shard.user_bin_indices.empty() && shard.user_bin_indices.size() != shard.filenames.size())
+        throw std::runtime_error{"The sketch file " + shard_filename.string() + " is corrupted: The number of user "
+                                 "bin indices does not match the number of user bins."};
+}
+
+int chopper_merge_sketches(chopper::configuration & config, sharg::parser & parser)
+{
+    parser.parse();
+
+    if (!chopper::sketch::has_sketch_file_extension(config.sketch_directory))
+        throw sharg::parser_error{"The sketch output file must have the extension \".sketch\" or \".sketches\"."};
+
+    size_t const number_of_shards{config.sketch_files.size()};
+    std::vector<chopper::sketch::sketch_file> shards(number_of_shards);
+
+    for (size_t i = 0; i < number_of_shards; ++i)
+    {
+        { // Deserialization is guaranteed to be complete when going out of scope.
+            std::ifstream is{config.sketch_files[i], std::ios::binary};
+            if (!is.good() || !is.is_open())
+                throw std::runtime_error{"Could not open sketch file " + config.sketch_files[i].string()
+                                         + " for reading."};
+            cereal::BinaryInputArchive iarchive{is};
+            iarchive(shards[i]);
+        }
+
+        if (shards[i].number_of_shards != number_of_shards)
+            throw std::runtime_error{sharg::detail::to_string("The sketch file ",
+                                                              config.sketch_files[i].string(),
+                                                              " belongs to a data file split into ",
+                                                              shards[i].number_of_shards,
+                                                              " shards, but ",
+                                                              number_of_shards,
+                                                              " sketch files were given.")};
+    }
+
+    // Empty shards carry no sketches and are not suited as reference.
+    auto const reference = std::ranges::find_if(shards,
+                                                [](chopper::sketch::sketch_file const & shard)
+                                                {
+                                                    return !shard.filenames.empty();
+                                                });
+
+    if (reference == shards.end())
+        throw std::runtime_error{"All given sketch files are empty."};
+
+    for (size_t i = 0; i < number_of_shards; ++i)
+        validate_shard(shards[i], *reference, config.sketch_files[i]);
+
+    chopper::sketch::sketch_file sout{.chopper_config = reference->chopper_config};
+
+    // The order of the given files does not matter. The shards are processed in the order of their shard index.
+    std::ranges::sort(shards,
+                      [](chopper::sketch::sketch_file const & lhs, chopper::sketch::sketch_file const & rhs)
+                      {
+                          return lhs.shard_index < rhs.shard_index;
+                      });
+
+    for (size_t i = 0; i < number_of_shards; ++i)
+        if (shards[i].shard_index != i)
+            throw std::runtime_error{sharg::detail::to_string("Shard ",
+                                                              i,
+                                                              '/',
+                                                              number_of_shards,
+                                                              " is missing or was given more than once.")};
+
+    size_t const number_of_user_bins = std::transform_reduce(shards.begin(),
+                                                             shards.end(),
+                                                             size_t{},
+                                                             std::plus<size_t>{},
+                                                             [](chopper::sketch::sketch_file const & shard)
+                                                             {
+                                                                 return shard.filenames.size();
+                                                             });
+
+    sout.filenames.resize(number_of_user_bins);
+    sout.hll_sketches.resize(number_of_user_bins);
+
+    // Priorities are only stored if any user bin has one.
+    if (std::ranges::any_of(shards,
+                            [](chopper::sketch::sketch_file const & shard)
+                            {
+                                return std::ranges::any_of(shard.priorities,
+                                                           [](size_t const priority)
+                                                           {
+                                                               return priority > 0u;
+                                                           });
+                            }))
+        sout.priorities.resize(number_of_user_bins);
+
+    // FPRs are only stored if any user bin has one.
+    if (std::ranges::any_of(shards,
+                            [](chopper::sketch::sketch_file const & shard)
+                            {
+                                return std::ranges::any_of(shard.fprs,
+                                                           [](double const fpr)
+                                                           {
+                                                               return fpr > 0.0;
+                                                           });
+                            }))
+        sout.fprs.resize(number_of_user_bins);
+
+    // Every user bin is placed at its global index. Shards without indices are contiguous blocks.
+    std::vector<bool> is_placed(number_of_user_bins, false);
+    size_t next_contiguous_index{};
+
+    for (chopper::sketch::sketch_file & shard : shards)
+    {
+        for (size_t i = 0; i < shard.filenames.size(); ++i)
+        {
+            size_t const idx = shard.user_bin_indices.empty() ? next_contiguous_index++ : shard.user_bin_indices[i];
+
+            if (idx >= number_of_user_bins || is_placed[idx])
+                throw std::runtime_error{sharg::detail::to_string("User bin ",
+                                                                  idx,
+                                                                  " of shard ",
+                                                                  shard.shard_index,
+                                                                  '/',
+                                                                  number_of_shards,
+                                                                  " is out of range or contained in multiple shards. "
+                                                                  "Were all shards computed from the same data file?")};
+
+            is_placed[idx] = true;
+            sout.filenames[idx] = std::move(shard.filenames[i]);
+            sout.hll_sketches[idx] = std::move(shard.hll_sketches[i]);
+            if (!sout.priorities.empty() && !shard.priorities.empty())
+                sout.priorities[idx] = shard.priorities[i];
+            if (!sout.fprs.empty() && !shard.fprs.empty())
+                sout.fprs[idx] = shard.fprs[i];
+        }
+
+        shard = chopper::sketch::sketch_file{}; // free memory early
+    }
+
+    sout.chopper_config.hibf_config.number_of_user_bins = number_of_user_bins;
+
+    if (config.similarity_neighbours > 0u)
+        chopper::sketch::write_similarity_store_next_to(config.sketch_directory,
+                                                        chopper::sketch::to_dense_sketches(sout.hll_sketches),
+                                                        config.similarity_neighbours,
+                                                        config.hibf_config.threads);
+
+    std::ofstream os{config.sketch_directory, std::ios::binary};
+    cereal::BinaryOutputArchive oarchive{os};
+    oarchive(sout);
+
+    return 0;
+}
+
+} // namespace chopper
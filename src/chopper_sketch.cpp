@@ -0,0 +1,137 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <charconv>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <ios>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <sharg/parser.hpp>
+
+#include <chopper/chopper_sketch.hpp>
+#include <chopper/configuration.hpp>
+#include <chopper/input_functor.hpp>
+#include <chopper/sketch/check_filenames.hpp>
+#include <chopper/sketch/compute_sketches.hpp>
+#include <chopper/sketch/read_data_file.hpp>
+#include <chopper/sketch/similarity_store.hpp>
+#include <chopper/sketch/sketch_file.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
+
+namespace chopper
+{
+
+//!\brief Parses `config.shard` ("i/n") into `config.shard_index` and `config.number_of_shards`.
+static void parse_shard(chopper::configuration & config)
+{
+    std::string_view const shard{config.shard};
+    size_t const slash_pos{shard.find('/')};
+
+    auto parse_number = [](std::string_view const str, size_t & value)
+    {
+        auto const [ptr, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+        return !str.empty() && error == std::errc{} && ptr == str.data() + str.size();
+    };
+
+    bool const valid = slash_pos != std::string_view::npos
+                    && parse_number(shard.substr(0, slash_pos), config.shard_index)
+                    && parse_number(shard.substr(slash_pos + 1), config.number_of_shards)
+                    && config.shard_index < config.number_of_shards;
+
+    if (!valid)
+        throw sharg::parser_error{"The --shard must have the format \"i/n\" with 0 <= i < n, but is \"" + config.shard
+                                  + "\"."};
+}
+
+int chopper_sketch(chopper::configuration & config, sharg::parser & parser)
+{
+    parser.parse();
+
+    if (!parser.is_option_set("window"))
+        config.window_size = config.k;
+    else if (config.k > config.window_size)
+        throw sharg::parser_error{"The k-mer size cannot be bigger than the window size."};
+
+    if (!chopper::sketch::has_sketch_file_extension(config.sketch_directory))
+        throw sharg::parser_error{"The sketch output file must have the extension \".sketch\" or \".sketches\"."};
+
+    parse_shard(config);
+
+    if (config.similarity_neighbours > 0u && config.number_of_shards > 1u)
+        throw sharg::parser_error{"The similarities of a sharded data file need all shards. Please pass "
+                                  "--similarity-neighbours to `chopper merge-sketches` instead."};
+
+    chopper::sketch::data_file_content data{chopper::sketch::read_data_file(config)};
+    std::vector<std::vector<std::string>> & filenames = data.filenames;
+
+    // A shard may legitimately be empty, e.g. when sharding a small data file by hash.
+    if (filenames.empty() && config.number_of_shards == 1u)
+        throw sharg::parser_error{
+            sharg::detail::to_string("The file ", config.data_file.string(), " appears to be empty.")};
+
+    std::vector<chopper::sketch::sparse_hyperloglog> sketches{};
+
+    if (!filenames.empty())
+    {
+        // Files need to exist because they will be read for sketching.
+        chopper::sketch::check_filenames(filenames, config);
+
+        auto const shared_filenames = std::make_shared<std::vector<std::vector<std::string>>>(std::move(filenames));
+        config.hibf_config.input_fn =
+            chopper::input_functor{shared_filenames, config.precomputed_files, config.k, config.window_size};
+        config.hibf_config.number_of_user_bins = shared_filenames->size();
+        config.hibf_config.validate_and_set_defaults();
+
+        config.compute_sketches_timer.start();
+        chopper::sketch::compute_sketches(config, sketches);
+        config.compute_sketches_timer.stop();
+
+        // The sketches are computed. Releasing the input functor leaves the filenames to this function.
+        config.hibf_config.input_fn = nullptr;
+        filenames = std::move(*shared_filenames);
+    }
+
+    if (config.similarity_neighbours > 0u)
+        chopper::sketch::write_similarity_store_next_to(config.sketch_directory,
+                                                        chopper::sketch::to_dense_sketches(sketches),
+                                                        config.similarity_neighbours,
+                                                        config.hibf_config.threads);
+
+    chopper::sketch::sketch_file sout{.chopper_config = config,
+                                      .filenames = std::move(filenames),
+                                      .hll_sketches = std::move(sketches),
+                                      .shard_index = config.shard_index,
+                                      .number_of_shards = config.number_of_shards,
+                                      .user_bin_indices = std::move(data.user_bin_indices),
+                                      .priorities = std::move(data.priorities),
+                                      .fprs = std::move(data.fprs)};
+    {
+        std::ofstream os{config.sketch_directory, std::ios::binary};
+        cereal::BinaryOutputArchive oarchive{os};
+        oarchive(sout);
+    }
+
+    if (!config.output_timings.empty())
+    {
+        std::ofstream output_stream{config.output_timings};
+        output_stream << std::fixed << std::setprecision(2);
+        output_stream << "sketching_in_seconds\n";
+        output_stream << config.compute_sketches_timer.in_seconds() << '\n';
+    }
+
+    return 0;
+}
+
+} // namespace chopper
@@ -0,0 +1,91 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <string>
+#include <vector>
+
+#include <sharg/exceptions.hpp>
+#include <sharg/parser.hpp>
+
+#include <cereal/archives/binary.hpp>
+
+#include <chopper/chopper_sweep.hpp>
+#include <chopper/configuration.hpp>
+#include <chopper/input_functor.hpp>
+#include <chopper/layout/ibf_query_cost.hpp>
+#include <chopper/layout/sweep.hpp>
+#include <chopper/sketch/sketch_file.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
+
+#include <hibf/sketch/estimate_kmer_counts.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper
+{
+
+int chopper_sweep(chopper::configuration & config, sharg::parser & parser)
+{
+    parser.parse();
+
+    if (!chopper::sketch::has_sketch_file_extension(config.data_file))
+        throw sharg::parser_error{"The input of chopper sweep must be a sketch file (\".sketch\" or \".sketches\"). "
+                                  "You can compute one with `chopper sketch`."};
+
+    for (double const fpr : config.sweep_fprs)
+        if (fpr <= 0.0 || fpr >= 1.0)
+            throw sharg::parser_error{"The --fpr values must be in (0, 1)."};
+
+    if (!config.query_cost_table.empty())
+        config.query_cost = chopper::layout::ibf_query_cost::read_from(config.query_cost_table);
+
+    chopper::sketch::sketch_file sin{};
+
+    { // Deserialization is guaranteed to be complete when going out of scope.
+        std::ifstream is{config.data_file, std::ios::binary};
+        cereal::BinaryInputArchive iarchive{is};
+        iarchive(sin);
+    }
+
+    if (sin.number_of_shards != 1u)
+        throw sharg::parser_error{sharg::detail::to_string("The sketch file ",
+                                                           config.data_file.string(),
+                                                           " only contains shard ",
+                                                           sin.shard_index,
+                                                           '/',
+                                                           sin.number_of_shards,
+                                                           ". Please combine all shards with "
+                                                           "`chopper merge-sketches` first.")};
+
+    // The sketches and k-mer counts are computed once and shared by all combinations.
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches =
+        chopper::sketch::to_dense_sketches(std::move(sin.hll_sketches));
+    std::vector<size_t> kmer_counts{};
+    seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
+
+    config.k = sin.chopper_config.k;
+    config.window_size = sin.chopper_config.window_size;
+    config.precomputed_files = sin.chopper_config.precomputed_files;
+    config.hibf_config.input_fn =
+        chopper::input_functor{chopper::make_filename_store(std::move(sin.filenames)),
+                               config.precomputed_files,
+                               config.k,
+                               config.window_size};
+    config.hibf_config.number_of_user_bins = sketches.size();
+    config.user_bin_fprs = std::move(sin.fprs);
+
+    auto const results = chopper::layout::sweep(config, kmer_counts, sketches, sin.priorities);
+
+    std::ofstream output_stream{config.output_filename};
+    chopper::layout::write_sweep_table_to(output_stream, results);
+
+    return 0;
+}
+
+} // namespace chopper
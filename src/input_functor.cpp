@@ -23,22 +23,19 @@
 namespace chopper
 {
 
-void input_functor::operator()(size_t const num, seqan::hibf::insert_iterator it)
+template <typename on_hash_t>
+void input_functor::for_each_hash(std::string const & filename, on_hash_t && on_hash) const
 {
-    assert(filenames.size() > num);
     if (input_are_precomputed_files)
     {
         uint64_t hash{};
         char * const hash_data{reinterpret_cast<char *>(&hash)};
         std::streamsize const hash_bytes{sizeof(hash)};
 
-        for (std::string const & filename : filenames[num])
-        {
-            std::ifstream infile{filename, std::ios::binary};
+        std::ifstream infile{filename, std::ios::binary};
 
-            while (infile.read(hash_data, hash_bytes))
-                it = hash;
-        }
+        while (infile.read(hash_data, hash_bytes))
+            on_hash(hash);
     }
     else
     {
@@ -47,17 +44,35 @@ void input_functor::operator()(size_t const num, seqan::hibf::insert_iterator it
                                                             seqan3::window_size{window_size},
                                                             seqan3::seed{adjust_seed(shape.count())});
 
-        for (std::string const & filename : filenames[num])
-        {
-            sequence_file_type fin{filename};
+        sequence_file_type fin{filename};
 
-            for (auto && [seq] : fin)
-            {
-                for (auto hash_value : seq | minimizer_view)
-                    it = hash_value;
-            }
+        for (auto && [seq] : fin)
+        {
+            for (auto hash_value : seq | minimizer_view)
+                on_hash(hash_value);
         }
     }
 }
 
+void input_functor::operator()(size_t const num, seqan::hibf::insert_iterator it)
+{
+    assert(filenames != nullptr && filenames->size() > num);
+
+    for (std::string const & filename : (*filenames)[num])
+        for_each_hash(filename,
+                      [&it](uint64_t const hash)
+                      {
+                          it = hash;
+                      });
+}
+
+void input_functor::add_to_sketch(std::string const & filename, seqan::hibf::sketch::hyperloglog & sketch) const
+{
+    for_each_hash(filename,
+                  [&sketch](uint64_t const hash)
+                  {
+                      sketch.add(hash);
+                  });
+}
+
 } // namespace chopper
@@ -0,0 +1,267 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/compute_grouped_layout.hpp>
+#include <chopper/sketch/similarity_store.hpp>
+
+#include <hibf/config.hpp>
+#include <hibf/layout/compute_layout.hpp>
+#include <hibf/layout/compute_relaxed_fpr_correction.hpp>
+#include <hibf/layout/layout.hpp>
+#include <hibf/misc/timer.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+std::vector<std::vector<size_t>> group_user_bins(configuration const & config,
+                                                 std::vector<size_t> const & kmer_counts,
+                                                 std::vector<size_t> const & positions,
+                                                 size_t const group_size)
+{
+    size_t const number_of_user_bins{positions.size()};
+    size_t const number_of_groups{(number_of_user_bins + group_size - 1u) / group_size};
+
+    // The first `number_of_user_bins % number_of_groups` groups hold one more user bin than the others.
+    auto group_capacity = [&](size_t const group)
+    {
+        return number_of_user_bins / number_of_groups + (group < number_of_user_bins % number_of_groups);
+    };
+
+    // The largest user bins seed the groups, like the DP algorithm, which also starts with the largest user bins.
+    std::vector<size_t> order{positions};
+    std::ranges::stable_sort(order,
+                             [&kmer_counts](size_t const lhs, size_t const rhs)
+                             {
+                                 return kmer_counts[lhs] > kmer_counts[rhs];
+                             });
+
+    // Only the user bins in `positions` may be grouped. All others count as already grouped.
+    std::vector<bool> is_grouped(kmer_counts.size(), true);
+    for (size_t const idx : positions)
+        is_grouped[idx] = false;
+
+    bool const use_similarities = config.similarities != nullptr && config.similarities->size() == kmer_counts.size();
+
+    std::vector<std::vector<size_t>> groups(1u);
+    std::deque<size_t> candidates{};
+    auto next_largest = order.begin();
+
+    for (size_t grouped = 0; grouped < number_of_user_bins; ++grouped)
+    {
+        while (!candidates.empty() && is_grouped[candidates.front()])
+            candidates.pop_front();
+
+        size_t idx{};
+        if (!candidates.empty())
+        {
+            idx = candidates.front();
+            candidates.pop_front();
+        }
+        else
+        {
+            while (is_grouped[*next_largest])
+                ++next_largest;
+            idx = *next_largest;
+        }
+
+        is_grouped[idx] = true;
+        groups.back().push_back(idx);
+
+        if (use_similarities)
+            for (auto const & neighbour : config.similarities->neighbours(idx))
+                if (!is_grouped[neighbour.index])
+                    candidates.push_back(neighbour.index);
+
+        if (groups.back().size() == group_capacity(groups.size() - 1u) && grouped + 1u < number_of_user_bins)
+        {
+            groups.emplace_back();
+            candidates.clear();
+        }
+    }
+
+    return groups;
+}
+
+size_t group_size_within_memory(configuration const & config,
+                                seqan::hibf::config const & hibf_config,
+                                size_t const number_of_user_bins)
+{
+    size_t const group_size{config.group_size == 0u ? number_of_user_bins : config.group_size};
+
+    if (config.max_memory_in_bytes == 0u)
+        return group_size;
+
+    // The groups are computed in parallel, each with its own matrices.
+    size_t const threads{std::max<size_t>(hibf_config.threads, 1u)};
+    size_t const parallel_layouts{group_size < number_of_user_bins ? threads : 1u};
+
+    if (parallel_layouts * estimate_dp_memory(hibf_config.tmax, std::min(group_size, number_of_user_bins))
+        <= config.max_memory_in_bytes)
+        return group_size;
+
+    size_t const largest_group_size{config.max_memory_in_bytes / threads / estimate_dp_memory(hibf_config.tmax, 1u)};
+
+    if (largest_group_size == 0u)
+        throw std::invalid_argument{"The layout of a single user bin with tmax " + std::to_string(hibf_config.tmax)
+                                    + " needs more memory than --max-memory allows per thread."};
+
+    return std::min(group_size, largest_group_size);
+}
+
+std::vector<std::vector<size_t>> divide_into_groups(configuration const & config,
+                                                    seqan::hibf::config const & hibf_config,
+                                                    std::vector<size_t> const & kmer_counts,
+                                                    std::vector<size_t> const & positions)
+{
+    size_t const group_size{group_size_within_memory(config, hibf_config, positions.size())};
+
+    if (positions.size() <= group_size)
+        return {};
+
+    return group_user_bins(config, kmer_counts, positions, group_size);
+}
+
+seqan::hibf::layout::layout compute_grouped_layout(configuration const & config,
+                                                   seqan::hibf::config const & hibf_config,
+                                                   std::vector<size_t> const & kmer_counts,
+                                                   std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                                   std::vector<size_t> positions)
+{
+    std::vector<std::vector<size_t>> groups = divide_into_groups(config, hibf_config, kmer_counts, positions);
+
+    if (groups.empty())
+        return seqan::hibf::layout::compute_layout(hibf_config,
+                                                   kmer_counts,
+                                                   sketches,
+                                                   std::move(positions),
+                                                   config.union_estimation_timer,
+                                                   config.rearrangement_timer);
+
+    if (groups.size() > hibf_config.tmax)
+        throw std::invalid_argument{"The " + std::to_string(positions.size()) + " user bins are divided into "
+                                    + std::to_string(groups.size()) + " groups, but there are only "
+                                    + std::to_string(hibf_config.tmax) + " technical bins on the top level. "
+                                    + "Please increase --group-size, --max-memory or --tmax."};
+
+    // The groups are computed in parallel. Each DP itself is computed with a single thread.
+    seqan::hibf::config group_config{hibf_config};
+    group_config.threads = 1u;
+
+    std::vector<seqan::hibf::layout::layout> group_layouts(groups.size());
+    std::vector<double> group_sizes(groups.size());
+    std::vector<std::exception_ptr> errors(groups.size());
+
+    // Each group has its own timers. A timer must not be started and stopped by several threads at once.
+    std::vector<seqan::hibf::concurrent_timer> union_estimation_timers(groups.size());
+    std::vector<seqan::hibf::concurrent_timer> rearrangement_timers(groups.size());
+
+    double const relaxed_fpr_correction{seqan::hibf::layout::compute_relaxed_fpr_correction(
+        {.fpr = hibf_config.maximum_fpr,
+         .relaxed_fpr = hibf_config.relaxed_fpr,
+         .hash_count = hibf_config.number_of_hash_functions})};
+
+    // The groups are independent. Each thread takes the next group as soon as it is done with its previous one.
+    // The results are stored by group and composed afterwards, so the layout does not depend on the number of threads.
+#pragma omp parallel for schedule(dynamic) num_threads(hibf_config.threads)
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        try
+        {
+            // A group of a single user bin becomes a split bin with one technical bin. It needs no lower-level IBF.
+            if (groups[i].size() == 1u)
+            {
+                group_sizes[i] = kmer_counts[groups[i][0]];
+                continue;
+            }
+
+            // All other top-level bins are merged bins with the same FPR correction. The largest union determines the
+            // size.
+            if (hibf_config.disable_estimate_union)
+            {
+                for (size_t const idx : groups[i])
+                    group_sizes[i] += kmer_counts[idx];
+            }
+            else
+            {
+                seqan::hibf::sketch::hyperloglog union_sketch{hibf_config.sketch_bits};
+                for (size_t const idx : groups[i])
+                    union_sketch.merge(sketches[idx]);
+                group_sizes[i] = union_sketch.estimate();
+            }
+            group_sizes[i] *= relaxed_fpr_correction;
+
+            group_layouts[i] = seqan::hibf::layout::compute_layout(group_config,
+                                                                   kmer_counts,
+                                                                   sketches,
+                                                                   std::move(groups[i]),
+                                                                   union_estimation_timers[i],
+                                                                   rearrangement_timers[i]);
+        }
+        catch (...)
+        {
+            errors[i] = std::current_exception(); // Exceptions must not leave the parallel region.
+        }
+    }
+
+    // The error of the first failing group is reported, independent of the number of threads.
+    for (std::exception_ptr const & error : errors)
+        if (error)
+            std::rethrow_exception(error);
+
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        config.union_estimation_timer += union_estimation_timers[i];
+        config.rearrangement_timer += rearrangement_timers[i];
+    }
+
+    // Group i becomes the technical bin i of the top-level IBF.
+    seqan::hibf::layout::layout hibf_layout{};
+    hibf_layout.top_level_max_bin_id = std::ranges::max_element(group_sizes) - group_sizes.begin();
+
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        if (group_layouts[i].user_bins.empty()) // A single user bin. Its group was not moved.
+        {
+            hibf_layout.user_bins.push_back(
+                {.previous_TB_indices = {}, .storage_TB_id = i, .number_of_technical_bins = 1u, .idx = groups[i][0]});
+            continue;
+        }
+
+        seqan::hibf::layout::layout & group_layout = group_layouts[i];
+
+        hibf_layout.max_bins.push_back({.previous_TB_indices = {i}, .id = group_layout.top_level_max_bin_id});
+
+        for (auto & max_bin : group_layout.max_bins)
+        {
+            max_bin.previous_TB_indices.insert(max_bin.previous_TB_indices.begin(), i);
+            hibf_layout.max_bins.push_back(std::move(max_bin));
+        }
+
+        for (auto & user_bin : group_layout.user_bins)
+        {
+            user_bin.previous_TB_indices.insert(user_bin.previous_TB_indices.begin(), i);
+            hibf_layout.user_bins.push_back(std::move(user_bin));
+        }
+
+        group_layout = seqan::hibf::layout::layout{}; // free memory early
+    }
+
+    return hibf_layout;
+}
+
+} // namespace chopper::layout
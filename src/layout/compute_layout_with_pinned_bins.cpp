@@ -0,0 +1,253 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/compute_grouped_layout.hpp>
+#include <chopper/layout/compute_layout_with_pinned_bins.hpp>
+
+#include <hibf/layout/compute_fpr_correction.hpp>
+#include <hibf/layout/compute_relaxed_fpr_correction.hpp>
+#include <hibf/layout/layout.hpp>
+#include <hibf/misc/iota_vector.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+//!\brief The corrected number of k-mers in the top-level technical bin `tb_index` of `hibf_layout`.
+static double top_level_bin_size(configuration const & config,
+                                 seqan::hibf::layout::layout const & hibf_layout,
+                                 size_t const tb_index,
+                                 std::vector<size_t> const & kmer_counts,
+                                 std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                 std::vector<double> const & fpr_correction)
+{
+    for (auto const & user_bin : hibf_layout.user_bins)
+    {
+        if (!user_bin.previous_TB_indices.empty() || tb_index < user_bin.storage_TB_id
+            || tb_index >= user_bin.storage_TB_id + user_bin.number_of_technical_bins)
+            continue;
+
+        // A split bin: the k-mers are distributed evenly over all of its technical bins.
+        double const size = static_cast<double>(kmer_counts[user_bin.idx]) / user_bin.number_of_technical_bins;
+        return size * fpr_correction[user_bin.number_of_technical_bins];
+    }
+
+    // A merged bin: all user bins in the lower levels below `tb_index`.
+    seqan::hibf::sketch::hyperloglog merged_sketch{config.hibf_config.sketch_bits};
+    size_t kmer_sum{};
+
+    for (auto const & user_bin : hibf_layout.user_bins)
+    {
+        if (user_bin.previous_TB_indices.empty() || user_bin.previous_TB_indices[0] != tb_index)
+            continue;
+
+        kmer_sum += kmer_counts[user_bin.idx];
+        if (!config.hibf_config.disable_estimate_union)
+            merged_sketch.merge(sketches[user_bin.idx]);
+    }
+
+    double const size = config.hibf_config.disable_estimate_union ? kmer_sum : merged_sketch.estimate();
+    return size
+         * seqan::hibf::layout::compute_relaxed_fpr_correction(
+               {.fpr = config.hibf_config.maximum_fpr,
+                .relaxed_fpr = config.hibf_config.relaxed_fpr,
+                .hash_count = config.hibf_config.number_of_hash_functions});
+}
+
+//!\brief The top-level technical bins of each pinned user bin: its share of all k-mers on `tmax` technical bins.
+static std::vector<size_t> number_of_pinned_technical_bins(configuration const & config,
+                                                           std::vector<size_t> const & kmer_counts,
+                                                           std::vector<size_t> const & pinned)
+{
+    // Each pinned user bin gets the technical bins it would occupy if all k-mers were spread evenly.
+    double const average_bin_size{std::accumulate(kmer_counts.begin(), kmer_counts.end(), 0.0)
+                                  / config.hibf_config.tmax};
+    std::vector<size_t> number_of_pinned_tbs(pinned.size());
+    for (size_t i = 0; i < pinned.size(); ++i)
+        number_of_pinned_tbs[i] =
+            std::max<size_t>(1u, std::floor(kmer_counts[pinned[i]] / std::max(average_bin_size, 1.0)));
+
+    return number_of_pinned_tbs;
+}
+
+//!\brief Splits the user bins into those with a priority greater than 0 and the remaining ones.
+static std::pair<std::vector<size_t>, std::vector<size_t>> split_pinned(size_t const number_of_user_bins,
+                                                                        std::vector<size_t> const & priorities)
+{
+    std::vector<size_t> pinned{};
+    std::vector<size_t> remaining{};
+
+    for (size_t i = 0; i < number_of_user_bins; ++i)
+        (i < priorities.size() && priorities[i] > 0u ? pinned : remaining).push_back(i);
+
+    return {std::move(pinned), std::move(remaining)};
+}
+
+std::vector<std::vector<size_t>> divide_unpinned_into_groups(configuration const & config,
+                                                             std::vector<size_t> const & kmer_counts,
+                                                             std::vector<size_t> const & priorities)
+{
+    auto const [pinned, remaining] = split_pinned(kmer_counts.size(), priorities);
+    std::vector<size_t> const number_of_pinned_tbs = number_of_pinned_technical_bins(config, kmer_counts, pinned);
+    size_t const pinned_tbs{std::accumulate(number_of_pinned_tbs.begin(), number_of_pinned_tbs.end(), size_t{})};
+
+    // compute_layout_with_pinned_bins() fails if there are no technical bins left.
+    if (pinned_tbs >= config.hibf_config.tmax)
+        return {};
+
+    seqan::hibf::config remaining_config{config.hibf_config};
+    remaining_config.tmax -= pinned_tbs;
+    return divide_into_groups(config, remaining_config, kmer_counts, remaining);
+}
+
+seqan::hibf::layout::layout
+compute_layout_with_pinned_bins(configuration const & config,
+                                std::vector<size_t> const & kmer_counts,
+                                std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                std::vector<size_t> const & priorities)
+{
+    auto [pinned, remaining] = split_pinned(kmer_counts.size(), priorities);
+
+    if (pinned.empty())
+        return compute_grouped_layout(config,
+                                      config.hibf_config,
+                                      kmer_counts,
+                                      sketches,
+                                      seqan::hibf::iota_vector(sketches.size()));
+
+    size_t const tmax{config.hibf_config.tmax};
+    std::vector<size_t> const number_of_pinned_tbs = number_of_pinned_technical_bins(config, kmer_counts, pinned);
+    size_t const pinned_tbs{std::accumulate(number_of_pinned_tbs.begin(), number_of_pinned_tbs.end(), size_t{})};
+
+    if (pinned_tbs > tmax || (!remaining.empty() && pinned_tbs == tmax))
+        throw std::invalid_argument{"The " + std::to_string(pinned.size()) + " pinned user bins need "
+                                    + std::to_string(pinned_tbs) + " technical bins on the top level, but there "
+                                    + "are only " + std::to_string(tmax) + " (--tmax) for all user bins."};
+
+    seqan::hibf::layout::layout hibf_layout{};
+
+    if (!remaining.empty()) // All user bins may be pinned.
+    {
+        seqan::hibf::config remaining_config{config.hibf_config};
+        remaining_config.tmax = tmax - pinned_tbs;
+        hibf_layout = compute_grouped_layout(config, remaining_config, kmer_counts, sketches, std::move(remaining));
+    }
+
+    // The pinned user bins are placed behind the top-level technical bins of the remaining layout.
+    size_t next_tb{};
+    for (auto const & user_bin : hibf_layout.user_bins)
+        next_tb = std::max(next_tb,
+                           user_bin.previous_TB_indices.empty()
+                               ? user_bin.storage_TB_id + user_bin.number_of_technical_bins
+                               : user_bin.previous_TB_indices[0] + 1u);
+    assert(next_tb + pinned_tbs <= tmax);
+
+    std::vector<double> const fpr_correction =
+        seqan::hibf::layout::compute_fpr_correction({.fpr = config.hibf_config.maximum_fpr,
+                                                     .hash_count = config.hibf_config.number_of_hash_functions,
+                                                     .t_max = tmax});
+
+    double max_bin_size{hibf_layout.user_bins.empty()
+                            ? 0.0
+                            : top_level_bin_size(config,
+                                                 hibf_layout,
+                                                 hibf_layout.top_level_max_bin_id,
+                                                 kmer_counts,
+                                                 sketches,
+                                                 fpr_correction)};
+
+    for (size_t i = 0; i < pinned.size(); ++i)
+    {
+        hibf_layout.user_bins.push_back({.previous_TB_indices = {},
+                                         .storage_TB_id = next_tb,
+                                         .number_of_technical_bins = number_of_pinned_tbs[i],
+                                         .idx = pinned[i]});
+
+        double const bin_size = static_cast<double>(kmer_counts[pinned[i]]) / number_of_pinned_tbs[i]
+                              * fpr_correction[number_of_pinned_tbs[i]];
+
+        // The top-level IBF is sized by its largest technical bin.
+        if (bin_size > max_bin_size)
+        {
+            max_bin_size = bin_size;
+            hibf_layout.top_level_max_bin_id = next_tb;
+        }
+
+        next_tb += number_of_pinned_tbs[i];
+    }
+
+    return hibf_layout;
+}
+
+seqan::hibf::layout::layout compute_single_level_layout(configuration const & config,
+                                                        std::vector<size_t> const & kmer_counts)
+{
+    size_t const tmax{config.hibf_config.tmax};
+    size_t const number_of_user_bins{kmer_counts.size()};
+
+    if (number_of_user_bins > tmax)
+        throw std::invalid_argument{"A layout with a single level needs at least one technical bin for each of the "
+                                    + std::to_string(number_of_user_bins) + " user bins, but --tmax is "
+                                    + std::to_string(tmax) + "."};
+
+    // (k-mers per technical bin, user bin). The next technical bin goes to the largest one.
+    std::vector<size_t> number_of_tbs(number_of_user_bins, 1u);
+    std::priority_queue<std::pair<double, size_t>> largest{};
+    for (size_t idx = 0; idx < number_of_user_bins; ++idx)
+        largest.emplace(static_cast<double>(kmer_counts[idx]), idx);
+
+    for (size_t remaining = tmax - number_of_user_bins; remaining > 0u && !largest.empty(); --remaining)
+    {
+        size_t const idx{largest.top().second};
+        largest.pop();
+        ++number_of_tbs[idx];
+        largest.emplace(static_cast<double>(kmer_counts[idx]) / number_of_tbs[idx], idx);
+    }
+
+    std::vector<double> const fpr_correction =
+        seqan::hibf::layout::compute_fpr_correction({.fpr = config.hibf_config.maximum_fpr,
+                                                     .hash_count = config.hibf_config.number_of_hash_functions,
+                                                     .t_max = tmax});
+    seqan::hibf::layout::layout hibf_layout{};
+    double max_bin_size{-1.0};
+    size_t next_tb{};
+
+    for (size_t idx = 0; idx < number_of_user_bins; ++idx)
+    {
+        hibf_layout.user_bins.push_back({.previous_TB_indices = {},
+                                         .storage_TB_id = next_tb,
+                                         .number_of_technical_bins = number_of_tbs[idx],
+                                         .idx = idx});
+
+        double const bin_size = static_cast<double>(kmer_counts[idx]) / number_of_tbs[idx]
+                              * fpr_correction[number_of_tbs[idx]];
+
+        if (bin_size > max_bin_size)
+        {
+            max_bin_size = bin_size;
+            hibf_layout.top_level_max_bin_id = next_tb;
+        }
+
+        next_tb += number_of_tbs[idx];
+    }
+
+    return hibf_layout;
+}
+
+} // namespace chopper::layout
@@ -0,0 +1,130 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/determine_best_fpr.hpp>
+#include <chopper/layout/determine_best_number_of_technical_bins.hpp>
+#include <chopper/layout/user_bin_fpr.hpp>
+
+#include <hibf/build/bin_size_in_bits.hpp>
+#include <hibf/config.hpp>
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+//!\brief The FPRs that are tried, in increasing order.
+static constexpr std::array<double, 11> fpr_candidates{0.0001, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+                                                       0.025,  0.05,   0.1,   0.2,    0.3};
+
+//!\brief Returns the number of hash functions in [1, 5] that minimises the size of a Bloom filter with the given FPR.
+size_t best_number_of_hash_functions(double const fpr)
+{
+    size_t best_hash_count{1u};
+    size_t best_size{std::numeric_limits<size_t>::max()};
+
+    // Fewer hash functions are faster to query, so only use more if the Bloom filter gets smaller.
+    for (size_t hash_count = 1u; hash_count <= 5u; ++hash_count)
+    {
+        size_t const size{
+            seqan::hibf::build::bin_size_in_bits({.fpr = fpr, .hash_count = hash_count, .elements = 1'000'000u})};
+
+        if (size < best_size)
+        {
+            best_size = size;
+            best_hash_count = hash_count;
+        }
+    }
+
+    return best_hash_count;
+}
+
+seqan::hibf::layout::layout determine_best_fpr(chopper::configuration & config,
+                                               std::vector<size_t> const & kmer_counts,
+                                               std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                               std::vector<size_t> const & priorities)
+{
+    seqan::hibf::config const original_hibf_config{config.hibf_config};
+    size_t last_tried{fpr_candidates.size()};
+
+    auto try_fpr = [&](size_t const fpr_index) -> std::optional<seqan::hibf::layout::layout>
+    {
+        last_tried = fpr_index;
+
+        config.hibf_config = original_hibf_config;
+        config.hibf_config.maximum_fpr = fpr_candidates[fpr_index];
+        use_strictest_fpr(config); // User bins with a stricter FPR keep it.
+
+        double const fpr{config.hibf_config.maximum_fpr};
+        config.hibf_config.relaxed_fpr = std::max(original_hibf_config.relaxed_fpr, fpr);
+        config.hibf_config.number_of_hash_functions = best_number_of_hash_functions(fpr);
+
+        try
+        {
+            return determine_best_number_of_technical_bins(config, kmer_counts, sketches, priorities);
+        }
+        catch (no_layout_within_limits const &)
+        {
+            return std::nullopt;
+        }
+    };
+
+    // A higher FPR always yields a smaller index. Find the lowest FPR that fits.
+    std::optional<seqan::hibf::layout::layout> best_layout{};
+    size_t best_index{};
+    size_t lower{0u};
+    size_t upper{fpr_candidates.size()};
+
+    while (lower < upper)
+    {
+        size_t const middle{lower + (upper - lower) / 2u};
+
+        if (auto layout = try_fpr(middle); layout.has_value())
+        {
+            best_layout = std::move(layout);
+            best_index = middle;
+            upper = middle;
+        }
+        else
+        {
+            lower = middle + 1u;
+        }
+    }
+
+    if (!best_layout.has_value())
+    {
+        std::ostringstream message{};
+        message << "Could not compute a layout that fits into " << config.max_index_size
+                << ", not even with a false positive rate of " << fpr_candidates.back() << '.';
+        throw no_layout_within_limits{message.str()};
+    }
+
+    // The statistics file and the configuration belong to the last tried FPR.
+    if (last_tried != best_index)
+        best_layout = try_fpr(best_index);
+
+    std::ofstream file_out{config.output_filename.string() + ".stats", std::ios::app};
+    file_out << "# Lowest false positive rate that fits into " << config.max_index_size << ": "
+             << config.hibf_config.maximum_fpr << " (relaxed: " << config.hibf_config.relaxed_fpr << ", "
+             << config.hibf_config.number_of_hash_functions << " hash functions)\n";
+
+    return std::move(*best_layout);
+}
+
+} // namespace chopper::layout
@@ -11,16 +11,20 @@
 #include <fstream>
 #include <limits>
 #include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include <chopper/configuration.hpp>
+#include <chopper/layout/compute_layout_with_pinned_bins.hpp>
 #include <chopper/layout/determine_best_number_of_technical_bins.hpp>
 #include <chopper/layout/hibf_statistics.hpp>
+#include <chopper/layout/number_of_levels.hpp>
 #include <chopper/next_multiple_of_64.hpp>
+#include <chopper/sketch/estimate_query_hits.hpp>
 
-#include <hibf/layout/compute_layout.hpp>
 #include <hibf/layout/layout.hpp>
 #include <hibf/sketch/compute_sketches.hpp>
 #include <hibf/sketch/hyperloglog.hpp>
@@ -31,7 +35,8 @@ namespace chopper::layout
 seqan::hibf::layout::layout
 determine_best_number_of_technical_bins(chopper::configuration & config,
                                         std::vector<size_t> const & kmer_counts,
-                                        std::vector<seqan::hibf::sketch::hyperloglog> const & sketches)
+                                        std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                        std::vector<size_t> const & priorities)
 {
     seqan::hibf::layout::layout best_layout;
 
@@ -61,30 +66,91 @@ determine_best_number_of_technical_bins(chopper::configuration & config,
              << "## number of hash functions = " << config.hibf_config.number_of_hash_functions << '\n'
              << "## maximum false positive rate = " << config.hibf_config.maximum_fpr << '\n'
              << "## relaxed false positive rate = " << config.hibf_config.relaxed_fpr << '\n';
+    if (!config.query_sample.empty())
+        file_out << "## query sample = " << config.query_sample.string() << '\n';
     hibf_statistics::print_header_to(file_out, config.output_verbose_statistics);
 
-    double best_expected_HIBF_query_cost{std::numeric_limits<double>::infinity()};
+    double best_weighted_cost{std::numeric_limits<double>::infinity()};
     size_t best_t_max{};
     size_t t_max_64_memory{};
+    std::ostringstream best_pinned_summary{};
 
-    for (size_t const t_max : potential_t_max)
+    // The query sample is only sketched once. The weights do not depend on the layout.
+    std::vector<double> const query_weights =
+        config.query_sample.empty() ? std::vector<double>{} : sketch::estimate_query_hits(config, sketches);
+
+    // Layouts that exceed config.max_levels or config.max_index_size_in_bytes are reported, but not selected.
+    size_t best_unlimited_t_max{};
+    size_t best_unlimited_size{};
+    size_t best_size{};
+    double best_unlimited_weighted_cost{std::numeric_limits<double>::infinity()};
+
+    for (auto it = potential_t_max.begin(); it != potential_t_max.end(); ++it)
     {
+        size_t const t_max{*it};
         config.hibf_config.tmax = t_max;
 
-        seqan::hibf::layout::layout tmp_layout =
-            seqan::hibf::layout::compute_layout(config.hibf_config, kmer_counts, sketches);
+        seqan::hibf::layout::layout tmp_layout{};
+
+        try
+        {
+            tmp_layout = compute_layout_with_pinned_bins(config, kmer_counts, sketches, priorities);
+        }
+        catch (std::invalid_argument const &)
+        {
+            // The pinned user bins do not fit into t_max technical bins. A larger t_max may work.
+            if (t_max == *potential_t_max.rbegin() && best_t_max == 0u)
+                throw;
+            continue;
+        }
+
+        // The layout algorithm may merge user bins if this is cheaper, even if there are enough technical bins for
+        // all user bins. With at least as many technical bins as user bins, a single level always exists.
+        if (config.max_levels > 0u && number_of_levels(tmp_layout) > config.max_levels
+            && t_max >= config.hibf_config.number_of_user_bins)
+            tmp_layout = compute_single_level_layout(config, kmer_counts);
+
+        bool const within_level_limit = config.max_levels == 0u || number_of_levels(tmp_layout) <= config.max_levels;
+
+        // If no layout up to tmax respects the level limit, wider IBFs are tried.
+        if (!within_level_limit && best_t_max == 0u && t_max == *potential_t_max.rbegin())
+            potential_t_max.insert(2u * t_max);
 
         chopper::layout::hibf_statistics global_stats{config, sketches, kmer_counts};
         global_stats.hibf_layout = tmp_layout;
+        global_stats.query_weights = query_weights;
         global_stats.finalize();
         global_stats.print_summary_to(t_max_64_memory, file_out, config.output_verbose_statistics);
 
+        // The weighted geometric mean of query cost and memory, both relative to t_max = 64.
+        // With the default weight of 1, only the expected query cost is considered.
+        size_t const size = global_stats.total_hibf_size_in_byte();
+        double const relative_memory_size = size / static_cast<double>(t_max_64_memory);
+        double const weighted_cost = std::pow(global_stats.expected_HIBF_query_cost, config.query_cost_weight)
+                                   * std::pow(relative_memory_size, 1.0 - config.query_cost_weight);
+
+        if (weighted_cost < best_unlimited_weighted_cost)
+        {
+            best_unlimited_t_max = t_max;
+            best_unlimited_size = size;
+            best_unlimited_weighted_cost = weighted_cost;
+        }
+
+        bool const within_size_limit =
+            config.max_index_size_in_bytes == 0u || size <= config.max_index_size_in_bytes;
+
+        if (!within_level_limit || !within_size_limit)
+            continue;
+
         // Use result if better than previous one.
-        if (global_stats.expected_HIBF_query_cost < best_expected_HIBF_query_cost)
+        if (weighted_cost < best_weighted_cost)
         {
             best_layout = std::move(tmp_layout);
             best_t_max = t_max;
-            best_expected_HIBF_query_cost = global_stats.expected_HIBF_query_cost;
+            best_size = size;
+            best_weighted_cost = weighted_cost;
+            best_pinned_summary.str("");
+            global_stats.print_pinned_summary_to(priorities, best_pinned_summary);
         }
         else if (!config.force_all_binnings)
         {
@@ -92,7 +158,29 @@ determine_best_number_of_technical_bins(chopper::configuration & config,
         }
     }
 
-    file_out << "# Best t_max (regarding expected query runtime): " << best_t_max << '\n';
+    if (best_t_max == 0u)
+        throw no_layout_within_limits{"Could not compute a layout"
+                                      + (config.max_levels > 0u
+                                             ? " with at most " + std::to_string(config.max_levels) + " levels"
+                                             : std::string{})
+                                      + (config.max_index_size_in_bytes > 0u
+                                             ? " that fits into " + config.max_index_size
+                                             : std::string{})
+                                      + "."};
+
+    if (config.query_cost_weight == 1.0)
+        file_out << "# Best t_max (regarding expected query runtime): " << best_t_max << '\n';
+    else
+        file_out << "# Best t_max (regarding expected query runtime with weight " << config.query_cost_weight
+                 << " and memory with weight " << 1.0 - config.query_cost_weight << "): " << best_t_max << '\n';
+    file_out << best_pinned_summary.str();
+    if (config.max_levels > 0u)
+        hibf_statistics::print_level_limit_summary_to(file_out,
+                                                      config.max_levels,
+                                                      best_t_max,
+                                                      best_size,
+                                                      best_unlimited_t_max,
+                                                      best_unlimited_size);
     config.hibf_config.tmax = best_t_max;
 
     return best_layout;
@@ -5,6 +5,7 @@
 // shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
 // ---------------------------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <cassert>
 #include <cinttypes>
 #include <cmath>
@@ -12,62 +13,246 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <stdexcept>
 #include <string>
 #include <tuple>
 #include <vector>
 
 #include <chopper/configuration.hpp>
+#include <chopper/input_functor.hpp>
+#include <chopper/layout/compute_grouped_layout.hpp>
+#include <chopper/layout/compute_layout_with_pinned_bins.hpp>
+#include <chopper/layout/determine_best_fpr.hpp>
 #include <chopper/layout/determine_best_number_of_technical_bins.hpp>
 #include <chopper/layout/execute.hpp>
 #include <chopper/layout/hibf_statistics.hpp>
+#include <chopper/layout/number_of_levels.hpp>
 #include <chopper/layout/output.hpp>
-#include <chopper/next_multiple_of_64.hpp>
+#include <chopper/layout/partition_user_bins.hpp>
+#include <chopper/layout/refine_layout.hpp>
+#include <chopper/layout/stable_layout.hpp>
+#include <chopper/layout/user_bin_fpr.hpp>
 
-#include <hibf/layout/compute_layout.hpp>
 #include <hibf/layout/layout.hpp>
-#include <hibf/misc/iota_vector.hpp>
 #include <hibf/sketch/estimate_kmer_counts.hpp> // for estimate_kmer_counts
 #include <hibf/sketch/hyperloglog.hpp>
 
 namespace chopper::layout
 {
 
+/*!\brief Writes an independent layout for each partition of the user bins (see partition_user_bins).
+ * \details
+ * User bins with different FPRs are in different partitions. Each layout is sized at the FPR of its user bins.
+ */
+static int execute_partitions(chopper::configuration & config,
+                              std::vector<std::vector<std::string>> const & filenames,
+                              std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                              std::vector<size_t> const & priorities)
+{
+    std::vector<size_t> kmer_counts;
+    seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
+
+    config.dp_algorithm_timer.start();
+    std::vector<std::vector<size_t>> const partitions =
+        partition_user_bins(config, kmer_counts, sketches, priorities);
+    config.dp_algorithm_timer.stop();
+
+    int exit_code{};
+
+    for (size_t partition = 0; partition < partitions.size(); ++partition)
+    {
+        std::vector<size_t> const & user_bins = partitions[partition];
+        chopper::filename_store const partition_filenames =
+            chopper::make_filename_store(select_user_bins(filenames, user_bins));
+
+        chopper::configuration partition_config = partition_configuration(config, partition, user_bins);
+        partition_config.hibf_config.input_fn =
+            chopper::input_functor{partition_filenames, config.precomputed_files, config.k, config.window_size};
+
+        exit_code |= execute(partition_config,
+                             *partition_filenames,
+                             select_user_bins(sketches, user_bins),
+                             select_user_bins(priorities, user_bins));
+    }
+
+    return exit_code;
+}
+
+//!\brief Prints into which groups the user bins of `hibf_layout` are divided, if they are.
+static std::vector<std::vector<size_t>> print_grouping(chopper::configuration const & config,
+                                                       seqan::hibf::layout::layout const & hibf_layout,
+                                                       std::vector<size_t> const & kmer_counts,
+                                                       std::vector<size_t> const & priorities)
+{
+    // A layout with a single level (see compute_single_level_layout()) does not group the user bins.
+    std::vector<std::vector<size_t>> groups = number_of_levels(hibf_layout) > 1u
+                                                ? divide_unpinned_into_groups(config, kmer_counts, priorities)
+                                                : std::vector<std::vector<size_t>>{};
+
+    if (groups.empty())
+        return groups;
+
+    // Each group is a technical bin of the top level: a merged bin or, for a single user bin, a split bin.
+    // The refinement may have moved user bins between these. Pinned user bins do not belong to a group.
+    std::map<size_t, std::vector<size_t>> groups_by_tb{};
+    for (auto const & user_bin : hibf_layout.user_bins)
+    {
+        bool const is_pinned = user_bin.idx < priorities.size() && priorities[user_bin.idx] > 0u;
+
+        if (!user_bin.previous_TB_indices.empty())
+            groups_by_tb[user_bin.previous_TB_indices[0]].push_back(user_bin.idx);
+        else if (!is_pinned)
+            groups_by_tb[user_bin.storage_TB_id].push_back(user_bin.idx);
+    }
+
+    groups.clear();
+    for (auto & [tb, group] : groups_by_tb)
+        groups.push_back(std::move(group));
+
+    hibf_statistics::print_grouping_to(std::cout, groups);
+    return groups;
+}
+
 int execute(chopper::configuration & config,
             std::vector<std::vector<std::string>> const & filenames,
-            std::vector<seqan::hibf::sketch::hyperloglog> const & sketches)
+            std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+            std::vector<size_t> const & priorities)
 {
     config.hibf_config.validate_and_set_defaults();
 
+    // The layout file carries a single FPR for all IBFs. User bins with different FPRs are laid out separately.
+    if (config.number_of_partitions > 1u || fpr_classes(config).size() > 1u)
+    {
+        if (!config.previous_layout.empty())
+            throw std::invalid_argument{"A previous layout cannot be combined with partitions or different FPRs."};
+
+        return execute_partitions(config, filenames, sketches, priorities);
+    }
+
+    use_strictest_fpr(config);
+
     seqan::hibf::layout::layout hibf_layout;
     std::vector<size_t> kmer_counts;
     seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
 
+    // Wider IBFs need fewer levels. Keep the layout without the limit to report what the limit costs.
+    seqan::hibf::layout::layout unlimited_layout{};
+    size_t const unlimited_t_max{config.hibf_config.tmax};
+
     if (config.determine_best_tmax)
     {
-        hibf_layout = determine_best_number_of_technical_bins(config, kmer_counts, sketches);
+        hibf_layout = config.max_index_size_in_bytes > 0u
+                        ? determine_best_fpr(config, kmer_counts, sketches, priorities)
+                        : determine_best_number_of_technical_bins(config, kmer_counts, sketches, priorities);
     }
     else
     {
         config.dp_algorithm_timer.start();
-        hibf_layout = seqan::hibf::layout::compute_layout(config.hibf_config,
-                                                          kmer_counts,
-                                                          sketches,
-                                                          seqan::hibf::iota_vector(sketches.size()),
-                                                          config.union_estimation_timer,
-                                                          config.rearrangement_timer);
+        hibf_layout = compute_layout_with_pinned_bins(config, kmer_counts, sketches, priorities);
+
+        if (config.max_levels > 0u && number_of_levels(hibf_layout) > config.max_levels)
+        {
+            unlimited_layout = hibf_layout;
+
+            while (number_of_levels(hibf_layout) > config.max_levels)
+            {
+                // The layout algorithm may merge user bins if this is cheaper, even if there are enough technical bins
+                // for all user bins. With at least as many technical bins as user bins, a single level always exists.
+                if (config.hibf_config.tmax >= config.hibf_config.number_of_user_bins)
+                {
+                    hibf_layout = compute_single_level_layout(config, kmer_counts);
+                    break;
+                }
+
+                config.hibf_config.tmax *= 2u;
+                hibf_layout = compute_layout_with_pinned_bins(config, kmer_counts, sketches, priorities);
+            }
+        }
         config.dp_algorithm_timer.stop();
+    }
 
-        if (config.output_verbose_statistics)
+    // The statistics below describe the refined layout.
+    refinement_result refinement{};
+    if (config.refinement_time > 0.0)
+        refinement = refine_layout(config, hibf_layout, kmer_counts, sketches, priorities);
+
+    std::vector<std::vector<size_t>> const groups = print_grouping(config, hibf_layout, kmer_counts, priorities);
+
+    if (!config.determine_best_tmax && config.output_verbose_statistics)
+    {
+        size_t dummy{};
+        chopper::layout::hibf_statistics global_stats{config, sketches, kmer_counts};
+        global_stats.hibf_layout = hibf_layout;
+        global_stats.print_header_to(std::cout);
+        global_stats.print_summary_to(dummy, std::cout);
+        global_stats.print_pinned_summary_to(priorities, std::cout);
+
+        // Compare a layout divided into groups to a single layout of all user bins.
+        if (!groups.empty())
+        {
+            // A single layout of all user bins is only computed if it fits into --max-memory.
+            if (config.max_memory_in_bytes > 0u
+                && estimate_dp_memory(config.hibf_config.tmax, config.hibf_config.number_of_user_bins)
+                       > config.max_memory_in_bytes)
+            {
+                std::cout << "# A single layout of all user bins is not computed for comparison because it "
+                             "needs more memory than --max-memory allows\n";
+            }
+            else
+            {
+                chopper::configuration monolithic_config{config};
+                monolithic_config.group_size = 0u;
+                monolithic_config.max_memory_in_bytes = 0u;
+                chopper::layout::hibf_statistics monolithic_stats{config, sketches, kmer_counts};
+                monolithic_stats.hibf_layout =
+                    compute_layout_with_pinned_bins(monolithic_config, kmer_counts, sketches, priorities);
+                monolithic_stats.finalize();
+
+                hibf_statistics::print_grouped_summary_to(std::cout,
+                                                          global_stats.total_hibf_size_in_byte(),
+                                                          global_stats.expected_HIBF_query_cost,
+                                                          monolithic_stats.total_hibf_size_in_byte(),
+                                                          monolithic_stats.expected_HIBF_query_cost);
+            }
+        }
+
+        if (!unlimited_layout.user_bins.empty())
         {
-            size_t dummy{};
-            chopper::layout::hibf_statistics global_stats{config, sketches, kmer_counts};
-            global_stats.hibf_layout = hibf_layout;
-            global_stats.print_header_to(std::cout);
-            global_stats.print_summary_to(dummy, std::cout);
+            chopper::configuration unlimited_config{config};
+            unlimited_config.hibf_config.tmax = unlimited_t_max;
+            chopper::layout::hibf_statistics unlimited_stats{unlimited_config, sketches, kmer_counts};
+            unlimited_stats.hibf_layout = unlimited_layout;
+
+            hibf_statistics::print_level_limit_summary_to(std::cout,
+                                                          config.max_levels,
+                                                          config.hibf_config.tmax,
+                                                          global_stats.total_hibf_size_in_byte(),
+                                                          unlimited_t_max,
+                                                          unlimited_stats.total_hibf_size_in_byte());
         }
     }
 
+    if (config.refinement_time > 0.0 && config.output_verbose_statistics)
+        hibf_statistics::print_refinement_summary_to(std::cout,
+                                                     refinement.moves,
+                                                     refinement.max_bin_size_before,
+                                                     refinement.max_bin_size_after);
+
+    if (!config.previous_layout.empty())
+    {
+        stabilization_result const result =
+            stabilize_layout(config, hibf_layout, filenames, kmer_counts, sketches, priorities);
+
+        if (config.output_verbose_statistics)
+            hibf_statistics::print_stability_summary_to(std::cout,
+                                                        result.kept_previous,
+                                                        result.size,
+                                                        result.rebuilt_fraction,
+                                                        result.alternative_size,
+                                                        result.alternative_rebuilt_fraction);
+    }
+
     // brief Write the output to the layout file.
     std::ofstream fout{config.output_filename};
     chopper::layout::write_user_bins_to(filenames, fout);
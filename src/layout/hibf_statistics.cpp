@@ -24,6 +24,7 @@
 #endif // CHOPPER_WORKAROUND_GCC_BOGUS_MEMCPY
 #include <map>
 #include <numeric>
+#include <ranges>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -62,6 +63,8 @@ hibf_statistics::hibf_statistics(configuration const & config_,
 
 void hibf_statistics::finalize()
 {
+    user_bin_query_costs.assign(counts.size(), 0.0);
+
     collect_bins();
 
     compute_cardinalities(top_level_ibf);
@@ -70,7 +73,10 @@ void hibf_statistics::finalize()
 
     gather_statistics(top_level_ibf, 0);
 
-    expected_HIBF_query_cost = total_query_cost / total_kmer_count;
+    double const total_weight = query_weights.empty()
+                                  ? static_cast<double>(total_kmer_count)
+                                  : std::accumulate(query_weights.begin(), query_weights.end(), 0.0);
+    expected_HIBF_query_cost = total_query_cost / total_weight;
 }
 
 //!\brief Prints a column names of the summary to the command line.
@@ -105,6 +111,120 @@ void hibf_statistics::print_header_to(std::ostream & stream, bool const verbose)
     stream << '\n';
 }
 
+void hibf_statistics::print_pinned_summary_to(std::vector<size_t> const & priorities, std::ostream & stream) const
+{
+    size_t number_of_pinned_user_bins{};
+    double pinned_query_cost{};
+    double pinned_weight{};
+
+    // Weighted like the expected query cost of all user bins, i.e. by query hits or by k-mer count.
+    for (size_t i = 0; i < priorities.size() && i < user_bin_query_costs.size(); ++i)
+    {
+        if (priorities[i] > 0u)
+        {
+            double const weight = query_weights.empty() ? static_cast<double>(counts[i]) : query_weights[i];
+            ++number_of_pinned_user_bins;
+            pinned_query_cost += user_bin_query_costs[i] * weight;
+            pinned_weight += weight;
+        }
+    }
+
+    if (number_of_pinned_user_bins == 0u)
+        return;
+
+    stream << std::fixed << std::setprecision(2) << "# Expected query cost of the " << number_of_pinned_user_bins
+           << " pinned user bins: " << (pinned_weight > 0.0 ? pinned_query_cost / pinned_weight : 0.0)
+           << " (all user bins: " << expected_HIBF_query_cost << ")\n"
+           << std::defaultfloat;
+}
+
+void hibf_statistics::print_level_limit_summary_to(std::ostream & stream,
+                                                   size_t const max_levels,
+                                                   size_t const t_max,
+                                                   size_t const size,
+                                                   size_t const unlimited_t_max,
+                                                   size_t const unlimited_size)
+{
+    double const relative_size_increase = 100.0 * (static_cast<double>(size) / unlimited_size - 1.0);
+
+    stream << std::fixed << std::setprecision(2) << "# Limiting the HIBF to " << max_levels << " levels: t_max "
+           << t_max << " with " << byte_size_to_formatted_str(size) << " instead of t_max " << unlimited_t_max
+           << " with " << byte_size_to_formatted_str(unlimited_size) << " (" << std::showpos << relative_size_increase
+           << std::noshowpos << "% memory)\n"
+           << std::defaultfloat;
+}
+
+void hibf_statistics::print_grouping_to(std::ostream & stream, std::vector<std::vector<size_t>> const & groups)
+{
+    auto const [smallest, largest] = std::ranges::minmax(groups | std::views::transform(std::ranges::size));
+    size_t const number_of_user_bins{std::accumulate(groups.begin(),
+                                                     groups.end(),
+                                                     size_t{},
+                                                     [](size_t const sum, std::vector<size_t> const & group)
+                                                     {
+                                                         return sum + group.size();
+                                                     })};
+
+    stream << "# Dividing " << number_of_user_bins << " user bins into " << groups.size() << " groups of "
+           << smallest << " to " << largest << " user bins\n";
+}
+
+void hibf_statistics::print_grouped_summary_to(std::ostream & stream,
+                                               size_t const size,
+                                               double const query_cost,
+                                               size_t const monolithic_size,
+                                               double const monolithic_query_cost)
+{
+    double const relative_size_increase = 100.0 * (static_cast<double>(size) / monolithic_size - 1.0);
+    double const relative_query_cost_increase = 100.0 * (query_cost / monolithic_query_cost - 1.0);
+
+    stream << std::fixed << std::setprecision(2) << "# Grouped layout: " << byte_size_to_formatted_str(size)
+           << " and query cost " << query_cost << " instead of " << byte_size_to_formatted_str(monolithic_size)
+           << " and query cost " << monolithic_query_cost << " for a single layout of all user bins (" << std::showpos
+           << relative_size_increase << "% memory, " << relative_query_cost_increase << "% query cost)\n"
+           << std::noshowpos << std::defaultfloat;
+}
+
+void hibf_statistics::print_refinement_summary_to(std::ostream & stream,
+                                                  size_t const moves,
+                                                  double const max_bin_size_before,
+                                                  double const max_bin_size_after)
+{
+    double const relative_size_decrease =
+        max_bin_size_before > 0.0 ? 100.0 * (1.0 - max_bin_size_after / max_bin_size_before) : 0.0;
+
+    stream << std::fixed << std::setprecision(2) << "# Refining the layout: " << moves
+           << " changes, the largest top-level technical bin holds " << max_bin_size_after << " instead of "
+           << max_bin_size_before << " k-mers (-" << relative_size_decrease << "%)\n"
+           << std::defaultfloat;
+}
+
+void hibf_statistics::print_stability_summary_to(std::ostream & stream,
+                                                 bool const kept_previous,
+                                                 size_t const size,
+                                                 double const rebuilt_fraction,
+                                                 size_t const alternative_size,
+                                                 double const alternative_rebuilt_fraction)
+{
+    stream << std::fixed << std::setprecision(2);
+
+    if (alternative_size == 0u)
+    {
+        stream << "# Relayout: the previous layout cannot be reused, the new layout needs "
+               << byte_size_to_formatted_str(size) << " (" << 100.0 * rebuilt_fraction << "% to rebuild)\n";
+    }
+    else
+    {
+        stream << "# Relayout: " << (kept_previous ? "keeping the previous layout" : "using a new layout")
+               << " with " << byte_size_to_formatted_str(size) << " (" << 100.0 * rebuilt_fraction
+               << "% to rebuild) instead of " << (kept_previous ? "a new layout" : "the previous layout") << " with "
+               << byte_size_to_formatted_str(alternative_size) << " (" << 100.0 * alternative_rebuilt_fraction
+               << "% to rebuild)\n";
+    }
+
+    stream << std::defaultfloat;
+}
+
 void hibf_statistics::print_summary_to(size_t & t_max_64_memory, std::ostream & stream, bool const verbose)
 {
     if (summaries.empty())
@@ -193,8 +313,7 @@ void hibf_statistics::print_summary_to(size_t & t_max_64_memory, std::ostream &
     stream /*        tmax */ << config.hibf_config.tmax
                              << '\t'
                              /*      c_tmax */
-                             << chopper::layout::ibf_query_cost::interpolated(config.hibf_config.tmax,
-                                                                              config.hibf_config.maximum_fpr)
+                             << config.query_cost.interpolated(config.hibf_config.tmax, config.hibf_config.maximum_fpr)
                              << '\t'
                              /*      l_tmax */
                              << expected_HIBF_query_cost
@@ -472,7 +591,7 @@ void hibf_statistics::compute_total_query_cost(level & curr_level)
 {
     // Compute number of technical bins in current level (<= tmax)
     size_t number_of_tbs{0};
-    size_t level_kmer_count{0};
+    double level_weight{0.0};
     size_t index{0};
     std::vector<size_t> merged_bin_indices{};
     std::vector<seqan::hibf::sketch::hyperloglog> merged_bin_sketches{};
@@ -499,7 +618,8 @@ void hibf_statistics::compute_total_query_cost(level & curr_level)
         else if (current_bin.kind == bin_kind::split) // bin_kind::split
         {
             number_of_tbs += current_bin.num_spanning_tbs;
-            level_kmer_count += current_bin.cardinality;
+            level_weight += query_weights.empty() ? current_bin.cardinality
+                                                  : query_weights[current_bin.user_bin_indices[0]];
         }
         ++index;
     }
@@ -507,10 +627,14 @@ void hibf_statistics::compute_total_query_cost(level & curr_level)
 
     // Add cost of querying the current IBF
     // (how costly is querying number_of_tbs (e.g. 128 tbs) compared to 64 tbs given the current FPR)
-    curr_level.current_query_cost += ibf_query_cost::interpolated(number_of_tbs, config.hibf_config.maximum_fpr);
+    curr_level.current_query_cost += config.query_cost.interpolated(number_of_tbs, config.hibf_config.maximum_fpr);
+
+    for (bin const & current_bin : curr_level.bins)
+        if (current_bin.kind == bin_kind::split)
+            user_bin_query_costs[current_bin.user_bin_indices[0]] = curr_level.current_query_cost;
 
-    // Add costs of querying the HIBF for each kmer in this level.
-    total_query_cost += curr_level.current_query_cost * level_kmer_count;
+    // Add costs of querying the HIBF for each (expected query) kmer in this level.
+    total_query_cost += curr_level.current_query_cost * level_weight;
 
     // update query cost of all merged bins
     for (size_t i = 0; i < merged_bin_indices.size(); ++i)
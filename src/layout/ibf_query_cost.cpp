@@ -5,13 +5,23 @@
 // shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
 // ---------------------------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <array>
 #include <bit>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <ios>
+#include <istream>
+#include <iterator>
 #include <map>
+#include <ostream>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 #include <utility>
 
 #include <chopper/layout/ibf_query_cost.hpp>
@@ -19,7 +29,13 @@
 namespace chopper::layout
 {
 
-double ibf_query_cost::exact(size_t const t_max, double const fpr)
+ibf_query_cost::ibf_query_cost(table_type table) : cost_factors{std::move(table)}
+{
+    if (cost_factors.empty())
+        throw std::invalid_argument{"The query cost table does not contain any FPR."};
+}
+
+double ibf_query_cost::exact(size_t const t_max, double const fpr) const
 {
     auto it = find_closest_fpr(fpr);
 
@@ -29,28 +45,51 @@ double ibf_query_cost::exact(size_t const t_max, double const fpr)
         throw std::invalid_argument("No exact data available for this t_max.");
 }
 
-double ibf_query_cost::interpolated(size_t const t_max, double const fpr)
+double ibf_query_cost::interpolated(size_t const t_max, double const fpr) const
 {
-    auto it = find_closest_fpr(fpr);
+    // FPRs outside of the measured range use the closest row.
+    auto upper_it = cost_factors.lower_bound(fpr);
+
+    if (upper_it == cost_factors.end())
+        return interpolated(std::prev(upper_it)->second, t_max);
+
+    if (upper_it->first == fpr || upper_it == cost_factors.begin())
+        return interpolated(upper_it->second, t_max);
+
+    auto lower_it = std::prev(upper_it);
 
+    // The FPRs are roughly spaced geometrically (0.0001, 0.0005, ...), so interpolate in log-space.
+    double const weight{(std::log(fpr) - std::log(lower_it->first))
+                        / (std::log(upper_it->first) - std::log(lower_it->first))};
+    double const lower_value{interpolated(lower_it->second, t_max)};
+    double const upper_value{interpolated(upper_it->second, t_max)};
+
+    return lower_value + weight * (upper_value - lower_value);
+}
+
+double ibf_query_cost::interpolated(factors_type const & factors, size_t const t_max)
+{
     if (t_max <= 64u)
     {
-        return it->second[0];
+        return factors[0];
     }
     else if (t_max > maximum_t_max)
     {
-        throw std::invalid_argument("No data available for a t_max this large.");
+        // The cost grows like t_max^exponent, with the exponent of the last doubling.
+        double const last_value{factors[position(maximum_t_max)]};
+        double const exponent{std::log2(last_value / factors[position(maximum_t_max >> 1)])};
+        return last_value * std::pow(static_cast<double>(t_max) / maximum_t_max, exponent);
     }
     else if (contains(t_max))
     {
-        return it->second[position(t_max)];
+        return factors[position(t_max)];
     }
     else
     {
         size_t const upper_bound{std::bit_ceil(t_max)};
         size_t const lower_bound{upper_bound >> 1};
-        double const upper_value{it->second[position(upper_bound)]};
-        double const lower_value{it->second[position(lower_bound)]};
+        double const upper_value{factors[position(upper_bound)]};
+        double const lower_value{factors[position(lower_bound)]};
 
         double const interpolated_value{lower_value
                                         + (upper_value - lower_value) * (t_max - lower_bound) / lower_bound};
@@ -59,7 +98,7 @@ double ibf_query_cost::interpolated(size_t const t_max, double const fpr)
     }
 }
 
-std::map<double, std::array<double, 11>>::const_iterator ibf_query_cost::find_closest_fpr(double const fpr)
+ibf_query_cost::table_type::const_iterator ibf_query_cost::find_closest_fpr(double const fpr) const
 {
     if (auto it = cost_factors.find(fpr); it != cost_factors.end()) // fpr is found exaclty in map
         return it;
@@ -82,4 +121,67 @@ std::map<double, std::array<double, 11>>::const_iterator ibf_query_cost::find_cl
         return upper_it;
 }
 
+ibf_query_cost ibf_query_cost::read_from(std::istream & stream)
+{
+    table_type table{};
+    std::string line{};
+
+    while (std::getline(stream, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream line_stream{line};
+        double fpr{};
+        factors_type factors{};
+
+        if (!(line_stream >> fpr) || fpr <= 0.0 || fpr >= 1.0)
+            throw std::invalid_argument{"Invalid FPR in query cost table line: " + line};
+
+        for (double & factor : factors)
+            if (!(line_stream >> factor) || factor <= 0.0)
+                throw std::invalid_argument{"Expected " + std::to_string(number_of_t_max_values)
+                                            + " positive cost factors in query cost table line: " + line};
+
+        if (std::string rest; line_stream >> rest)
+            throw std::invalid_argument{"Too many values in query cost table line: " + line};
+
+        // A larger IBF is never cheaper to query. The interpolation relies on this.
+        if (!std::ranges::is_sorted(factors))
+            throw std::invalid_argument{"The cost factors must not decrease with t_max in query cost table line: "
+                                        + line};
+
+        if (!table.emplace(fpr, factors).second)
+            throw std::invalid_argument{"Duplicate FPR in query cost table line: " + line};
+    }
+
+    return ibf_query_cost{std::move(table)};
+}
+
+ibf_query_cost ibf_query_cost::read_from(std::filesystem::path const & path)
+{
+    std::ifstream stream{path};
+
+    if (!stream.good() || !stream.is_open())
+        throw std::invalid_argument{"Could not open query cost table " + path.string() + " for reading."};
+
+    return read_from(stream);
+}
+
+void ibf_query_cost::write_to(std::ostream & stream, table_type const & table)
+{
+    stream << "# FPR";
+    for (size_t t_max = 64u; t_max <= maximum_t_max; t_max *= 2u)
+        stream << '\t' << t_max;
+    stream << '\n';
+
+    for (auto const & [fpr, factors] : table)
+    {
+        stream << fpr;
+        for (double const factor : factors)
+            stream << '\t' << std::fixed << std::setprecision(4) << factor;
+        stream << std::defaultfloat << '\n';
+    }
+}
+
 } // namespace chopper::layout
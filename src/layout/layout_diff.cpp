@@ -0,0 +1,171 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <chopper/layout/layout_diff.hpp>
+
+#include <hibf/layout/layout.hpp>
+
+namespace chopper::layout
+{
+
+std::string user_bin_key(std::vector<std::string> const & filenames)
+{
+    std::string key{};
+
+    for (std::string const & filename : filenames)
+    {
+        if (!key.empty())
+            key.push_back(' ');
+        key += filename;
+    }
+
+    return key;
+}
+
+//!\brief A user bin in an IBF: its key, its technical bin and its number of technical bins (0 for a merged bin).
+using ibf_entry = std::tuple<std::string, size_t, size_t>;
+
+//!\brief The user bins of an IBF.
+struct ibf_content
+{
+    //!\brief The sorted entries of the user bins.
+    std::vector<ibf_entry> entries{};
+
+    //!\brief The number of k-mers inserted into the IBF.
+    size_t kmers{};
+};
+
+//!\brief Returns the content of each IBF of `hibf_layout`, by the path of technical bins to it.
+static std::map<std::vector<size_t>, ibf_content> ibf_contents(std::vector<std::vector<std::string>> const & filenames,
+                                                               seqan::hibf::layout::layout const & hibf_layout,
+                                                               std::vector<size_t> const & kmer_counts)
+{
+    std::map<std::vector<size_t>, ibf_content> contents{};
+
+    for (auto const & user_bin : hibf_layout.user_bins)
+    {
+        std::string const key{user_bin_key(filenames[user_bin.idx])};
+        size_t const kmers{kmer_counts.empty() ? 1u : kmer_counts[user_bin.idx]};
+        std::vector<size_t> path{};
+
+        for (size_t const tb : user_bin.previous_TB_indices)
+        {
+            ibf_content & content = contents[path];
+            content.entries.emplace_back(key, tb, 0u);
+            content.kmers += kmers;
+            path.push_back(tb);
+        }
+
+        ibf_content & content = contents[path];
+        content.entries.emplace_back(key, user_bin.storage_TB_id, user_bin.number_of_technical_bins);
+        content.kmers += kmers;
+    }
+
+    for (auto & [path, content] : contents)
+        std::ranges::sort(content.entries);
+
+    return contents;
+}
+
+layout_diff diff_layouts(std::vector<std::vector<std::string>> const & previous_filenames,
+                         seqan::hibf::layout::layout const & previous_layout,
+                         std::vector<std::vector<std::string>> const & filenames,
+                         seqan::hibf::layout::layout const & hibf_layout,
+                         std::vector<size_t> const & kmer_counts)
+{
+    layout_diff diff{};
+
+    // The user bins are compared by their placement.
+    std::unordered_map<std::string, seqan::hibf::layout::layout::user_bin const *> previous_user_bins{};
+    for (auto const & user_bin : previous_layout.user_bins)
+        previous_user_bins.emplace(user_bin_key(previous_filenames[user_bin.idx]), &user_bin);
+
+    size_t kept_user_bins{};
+    for (auto const & user_bin : hibf_layout.user_bins)
+    {
+        auto it = previous_user_bins.find(user_bin_key(filenames[user_bin.idx]));
+
+        if (it == previous_user_bins.end())
+        {
+            ++diff.added_user_bins;
+            continue;
+        }
+
+        ++kept_user_bins;
+        auto const & previous = *it->second;
+        if (previous.previous_TB_indices != user_bin.previous_TB_indices
+            || previous.storage_TB_id != user_bin.storage_TB_id
+            || previous.number_of_technical_bins != user_bin.number_of_technical_bins)
+            ++diff.moved_user_bins;
+    }
+    diff.removed_user_bins = previous_layout.user_bins.size() - kept_user_bins;
+
+    // The IBFs are compared by their content, regardless of their path.
+    std::set<std::vector<ibf_entry>> previous_ibfs{};
+    for (auto & [path, content] : ibf_contents(previous_filenames, previous_layout, {}))
+        previous_ibfs.insert(std::move(content.entries));
+
+    auto const contents = ibf_contents(filenames, hibf_layout, kmer_counts);
+    diff.number_of_ibfs = contents.size();
+
+    for (auto const & [path, content] : contents)
+    {
+        diff.total_kmers += content.kmers;
+
+        if (previous_ibfs.contains(content.entries))
+            continue;
+
+        diff.rebuilt_kmers += content.kmers;
+        diff.changed_ibfs.push_back(
+            {.previous_TB_indices = path, .user_bins = content.entries.size(), .kmers = content.kmers});
+    }
+
+    return diff;
+}
+
+void write_layout_diff_to(std::ostream & stream, layout_diff const & diff)
+{
+    stream << std::fixed << std::setprecision(2) << "# IBFs to rebuild: " << diff.changed_ibfs.size() << " of "
+           << diff.number_of_ibfs << '\n'
+           << "# User bins: " << diff.moved_user_bins << " moved, " << diff.added_user_bins << " added, "
+           << diff.removed_user_bins << " removed\n"
+           << "# K-mers to insert: " << diff.rebuilt_kmers << " of " << diff.total_kmers << " ("
+           << 100.0 * diff.rebuilt_fraction() << "%)\n"
+           << std::defaultfloat;
+
+    stream << "IBF\tUSER_BINS\tKMERS\n";
+
+    for (auto const & ibf : diff.changed_ibfs)
+    {
+        if (ibf.previous_TB_indices.empty())
+        {
+            stream << "HIGH_LEVEL_IBF";
+        }
+        else
+        {
+            stream << "MERGED_BIN_";
+            for (size_t i = 0; i < ibf.previous_TB_indices.size(); ++i)
+                stream << (i > 0u ? ";" : "") << ibf.previous_TB_indices[i];
+        }
+
+        stream << '\t' << ibf.user_bins << '\t' << ibf.kmers << '\n';
+    }
+}
+
+} // namespace chopper::layout
@@ -0,0 +1,220 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/compute_grouped_layout.hpp>
+#include <chopper/layout/compute_layout_with_pinned_bins.hpp>
+#include <chopper/layout/hibf_statistics.hpp>
+#include <chopper/layout/partition_user_bins.hpp>
+#include <chopper/layout/user_bin_fpr.hpp>
+
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+std::filesystem::path partition_layout_path(std::filesystem::path const & output_filename, size_t const partition)
+{
+    std::filesystem::path result{output_filename};
+    result.replace_filename(output_filename.stem().string() + '.' + std::to_string(partition)
+                            + output_filename.extension().string());
+    return result;
+}
+
+configuration partition_configuration(configuration const & config,
+                                      size_t const partition,
+                                      std::vector<size_t> const & user_bins)
+{
+    configuration result{config};
+    result.output_filename = partition_layout_path(config.output_filename, partition);
+    result.number_of_partitions = 1u;
+    result.similarities = nullptr; // The similarities refer to the indices of all user bins.
+    result.user_bin_fprs = select_user_bins(config.user_bin_fprs, user_bins);
+    result.hibf_config.number_of_user_bins = user_bins.size();
+    use_strictest_fpr(result);
+    return result;
+}
+
+//!\brief Cuts `order` into `number_of_partitions` contiguous, non-empty parts with similar sums of `weights`.
+static std::vector<std::vector<size_t>> cut_into_partitions(std::vector<size_t> const & order,
+                                                            std::vector<double> const & weights,
+                                                            size_t const number_of_partitions)
+{
+    double total_weight{};
+    for (size_t const idx : order)
+        total_weight += weights[idx];
+
+    std::vector<std::vector<size_t>> partitions(number_of_partitions);
+    size_t partition{};
+    double cumulative_weight{};
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        double const weight{weights[order[i]]};
+        double const target{total_weight * (partition + 1u) / number_of_partitions};
+        size_t const remaining_user_bins{order.size() - i};
+        size_t const remaining_partitions{number_of_partitions - partition - 1u};
+
+        // Each partition needs at least one user bin.
+        if (remaining_partitions > 0u && !partitions[partition].empty()
+            && (cumulative_weight + weight / 2.0 > target || remaining_user_bins == remaining_partitions))
+            ++partition;
+
+        partitions[partition].push_back(order[i]);
+        cumulative_weight += weight;
+    }
+
+    for (auto & user_bins : partitions)
+        std::ranges::sort(user_bins);
+
+    return partitions;
+}
+
+//!\brief Predicts the index size in bytes of the partition `user_bins`.
+static size_t predicted_size(configuration const & config,
+                             std::vector<size_t> const & kmer_counts,
+                             std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                             std::vector<size_t> const & priorities,
+                             std::vector<size_t> const & user_bins)
+{
+    configuration const partition_config = partition_configuration(config, 0u, user_bins);
+    std::vector<size_t> const partition_kmer_counts = select_user_bins(kmer_counts, user_bins);
+    std::vector<seqan::hibf::sketch::hyperloglog> const partition_sketches = select_user_bins(sketches, user_bins);
+
+    hibf_statistics stats{partition_config, partition_sketches, partition_kmer_counts};
+    stats.hibf_layout = compute_layout_with_pinned_bins(partition_config,
+                                                        partition_kmer_counts,
+                                                        partition_sketches,
+                                                        select_user_bins(priorities, user_bins));
+    return stats.total_hibf_size_in_byte();
+}
+
+//!\brief Splits the user bins `user_bins` of a single FPR class into `number_of_partitions` balanced partitions.
+static std::vector<std::vector<size_t>> split_fpr_class(configuration const & config,
+                                                        std::vector<size_t> const & kmer_counts,
+                                                        std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                                        std::vector<size_t> const & priorities,
+                                                        std::vector<size_t> const & user_bins,
+                                                        size_t const number_of_partitions)
+{
+    if (number_of_partitions == 1u)
+        return {user_bins};
+
+    // A single group of all user bins lists similar user bins next to each other.
+    std::vector<size_t> const order = group_user_bins(config, kmer_counts, user_bins, user_bins.size())[0];
+
+    std::vector<double> weights(kmer_counts.begin(), kmer_counts.end());
+    std::vector<std::vector<size_t>> best_partitions{};
+    size_t best_max_size{std::numeric_limits<size_t>::max()};
+
+    for (size_t round = 0; round < partition_balancing_rounds; ++round)
+    {
+        std::vector<std::vector<size_t>> partitions = cut_into_partitions(order, weights, number_of_partitions);
+        size_t max_size{};
+
+        for (auto const & user_bins_of_partition : partitions)
+        {
+            size_t const size = predicted_size(config, kmer_counts, sketches, priorities, user_bins_of_partition);
+            max_size = std::max(max_size, size);
+
+            // The next cut weighs each user bin by the predicted bytes per k-mer of its partition.
+            double kmer_sum{};
+            for (size_t const idx : user_bins_of_partition)
+                kmer_sum += kmer_counts[idx];
+
+            double const bytes_per_kmer = kmer_sum > 0.0 ? size / kmer_sum : 1.0;
+            for (size_t const idx : user_bins_of_partition)
+                weights[idx] = kmer_counts[idx] * bytes_per_kmer;
+        }
+
+        if (max_size < best_max_size)
+        {
+            best_max_size = max_size;
+            best_partitions = std::move(partitions);
+        }
+    }
+
+    return best_partitions;
+}
+
+/*!\brief Distributes `number_of_partitions` partitions among the FPR classes `classes`.
+ * \details
+ * Each class gets one partition. Each further partition goes to the class with the most k-mers per partition that
+ * has more user bins than partitions.
+ */
+static std::vector<size_t> partitions_per_fpr_class(std::vector<std::vector<size_t>> const & classes,
+                                                    std::vector<size_t> const & kmer_counts,
+                                                    size_t const number_of_partitions)
+{
+    std::vector<double> class_kmer_counts(classes.size());
+    for (size_t c = 0; c < classes.size(); ++c)
+        for (size_t const idx : classes[c])
+            class_kmer_counts[c] += kmer_counts[idx];
+
+    std::vector<size_t> result(classes.size(), 1u);
+
+    for (size_t partition = classes.size(); partition < number_of_partitions; ++partition)
+    {
+        size_t best_class{classes.size()};
+        double best_kmers_per_partition{-1.0};
+
+        for (size_t c = 0; c < classes.size(); ++c)
+        {
+            double const kmers_per_partition{class_kmer_counts[c] / result[c]};
+
+            if (result[c] < classes[c].size() && kmers_per_partition > best_kmers_per_partition)
+            {
+                best_class = c;
+                best_kmers_per_partition = kmers_per_partition;
+            }
+        }
+
+        assert(best_class < classes.size()); // There are at least as many user bins as partitions.
+        ++result[best_class];
+    }
+
+    return result;
+}
+
+std::vector<std::vector<size_t>> partition_user_bins(configuration const & config,
+                                                     std::vector<size_t> const & kmer_counts,
+                                                     std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                                     std::vector<size_t> const & priorities)
+{
+    size_t const number_of_user_bins{kmer_counts.size()};
+
+    if (number_of_user_bins < config.number_of_partitions)
+        throw std::invalid_argument{"Cannot divide " + std::to_string(number_of_user_bins) + " user bins into "
+                                    + std::to_string(config.number_of_partitions) + " partitions."};
+
+    // All IBFs of a layout share one FPR. User bins with different FPRs are laid out in different partitions.
+    std::vector<std::vector<size_t>> const classes = fpr_classes(config);
+    std::vector<size_t> const number_of_partitions =
+        partitions_per_fpr_class(classes, kmer_counts, std::max(config.number_of_partitions, classes.size()));
+
+    std::vector<std::vector<size_t>> result{};
+
+    for (size_t c = 0; c < classes.size(); ++c)
+        for (auto & partition :
+             split_fpr_class(config, kmer_counts, sketches, priorities, classes[c], number_of_partitions[c]))
+            result.push_back(std::move(partition));
+
+    return result;
+}
+
+} // namespace chopper::layout
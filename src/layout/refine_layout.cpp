@@ -0,0 +1,513 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/refine_layout.hpp>
+
+#include <hibf/layout/compute_fpr_correction.hpp>
+#include <hibf/layout/compute_relaxed_fpr_correction.hpp>
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+//!\brief Refines the top-level IBF of a layout. See refine_layout().
+class layout_refinement
+{
+public:
+    layout_refinement(configuration const & config_,
+                      seqan::hibf::layout::layout & hibf_layout_,
+                      std::vector<size_t> const & kmer_counts_,
+                      std::vector<seqan::hibf::sketch::hyperloglog> const & sketches_,
+                      std::vector<size_t> const & priorities) :
+        config{config_},
+        hibf_layout{hibf_layout_},
+        kmer_counts{kmer_counts_},
+        sketches{sketches_},
+        fpr_correction{
+            seqan::hibf::layout::compute_fpr_correction({.fpr = config_.hibf_config.maximum_fpr,
+                                                         .hash_count = config_.hibf_config.number_of_hash_functions,
+                                                         .t_max = config_.hibf_config.tmax})},
+        relaxed_fpr_correction{seqan::hibf::layout::compute_relaxed_fpr_correction(
+            {.fpr = config_.hibf_config.maximum_fpr,
+             .relaxed_fpr = config_.hibf_config.relaxed_fpr,
+             .hash_count = config_.hibf_config.number_of_hash_functions})}
+    {
+        std::map<size_t, top_level_bin> bins_by_first_tb{};
+
+        for (size_t pos = 0; pos < hibf_layout.user_bins.size(); ++pos)
+        {
+            auto const & user_bin = hibf_layout.user_bins[pos];
+
+            if (user_bin.previous_TB_indices.empty())
+            {
+                bins_by_first_tb[user_bin.storage_TB_id] = {
+                    .first_tb = user_bin.storage_TB_id,
+                    .number_of_tbs = user_bin.number_of_technical_bins,
+                    .is_pinned = user_bin.idx < priorities.size() && priorities[user_bin.idx] > 0u,
+                    .members = {pos}};
+            }
+            else
+            {
+                top_level_bin & bin = bins_by_first_tb[user_bin.previous_TB_indices[0]];
+                bin.first_tb = user_bin.previous_TB_indices[0];
+                bin.number_of_tbs = 1u;
+                bin.is_merged = true;
+                bin.members.push_back(pos);
+                bin.child_tbs = std::max(bin.child_tbs, first_unused_child_tb(user_bin));
+            }
+        }
+
+        for (auto & [first_tb, bin] : bins_by_first_tb)
+        {
+            update_size(bin);
+            used_tbs += bin.number_of_tbs;
+            bins.push_back(std::move(bin));
+        }
+    }
+
+    refinement_result run()
+    {
+        refinement_result result{};
+
+        if (bins.empty())
+            return result;
+
+        auto const deadline = std::chrono::steady_clock::now()
+                            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                  std::chrono::duration<double>{config.refinement_time});
+
+        sort_by_size();
+        result.max_bin_size_before = bins[by_size[0]].size;
+
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            size_t const largest{by_size[0]};
+            bool const improved = bins[largest].is_merged ? try_move_user_bin(largest, deadline)
+                                                          : try_add_technical_bin(largest);
+
+            if (!improved)
+                break;
+
+            ++result.moves;
+            sort_by_size();
+        }
+
+        result.max_bin_size_after = bins[by_size[0]].size;
+
+        if (result.moves > 0u)
+            hibf_layout.top_level_max_bin_id = bins[by_size[0]].first_tb;
+
+        return result;
+    }
+
+private:
+    //!\brief A single technical bin or a range of technical bins of the top-level IBF.
+    struct top_level_bin
+    {
+        //!\brief The id of the first technical bin.
+        size_t first_tb{};
+
+        //!\brief The number of technical bins. Always 1 for a merged bin.
+        size_t number_of_tbs{};
+
+        //!\brief Whether the bin is a merged bin.
+        bool is_merged{};
+
+        //!\brief Whether the bin is the split bin of a pinned user bin (see compute_layout_with_pinned_bins()).
+        bool is_pinned{};
+
+        //!\brief The positions in `hibf_layout.user_bins` of the split user bin or all user bins below the merged bin.
+        std::vector<size_t> members{};
+
+        //!\brief The number of technical bins of the lower-level IBF of a merged bin.
+        size_t child_tbs{};
+
+        //!\brief The union of the sketches of all members of a merged bin.
+        seqan::hibf::sketch::hyperloglog sketch{};
+
+        //!\brief The sum of the k-mer counts of all members of a merged bin.
+        size_t kmer_sum{};
+
+        //!\brief The corrected size of each technical bin.
+        double size{};
+    };
+
+    configuration const & config;
+    seqan::hibf::layout::layout & hibf_layout;
+    std::vector<size_t> const & kmer_counts;
+    std::vector<seqan::hibf::sketch::hyperloglog> const & sketches;
+    std::vector<double> const fpr_correction;
+    double const relaxed_fpr_correction;
+
+    //!\brief The bins of the top-level IBF, sorted by their first technical bin.
+    std::vector<top_level_bin> bins{};
+
+    //!\brief The indices of `bins`, sorted by decreasing size.
+    std::vector<size_t> by_size{};
+
+    //!\brief The number of technical bins of the top-level IBF.
+    size_t used_tbs{};
+
+    //!\brief The technical bin behind the one(s) that `user_bin` uses in the lower-level IBF of its merged bin.
+    static size_t first_unused_child_tb(seqan::hibf::layout::layout::user_bin const & user_bin)
+    {
+        return user_bin.previous_TB_indices.size() == 1u
+                 ? user_bin.storage_TB_id + user_bin.number_of_technical_bins
+                 : user_bin.previous_TB_indices[1] + 1u;
+    }
+
+    //!\brief The corrected size of a technical bin if the user bin at `pos` is split into `number_of_tbs` bins.
+    double split_size(size_t const pos, size_t const number_of_tbs) const
+    {
+        size_t const idx{hibf_layout.user_bins[pos].idx};
+        return static_cast<double>(kmer_counts[idx]) / number_of_tbs * fpr_correction[number_of_tbs];
+    }
+
+    //!\brief The corrected size of a merged bin with the union `sketch` and the k-mer sum `kmer_sum`.
+    double merged_size(seqan::hibf::sketch::hyperloglog const & sketch, size_t const kmer_sum) const
+    {
+        double const size = config.hibf_config.disable_estimate_union ? kmer_sum : sketch.estimate();
+        return size * relaxed_fpr_correction;
+    }
+
+    //!\brief Returns the union of the sketches of the user bins at `positions`.
+    seqan::hibf::sketch::hyperloglog union_of(std::vector<size_t> const & positions) const
+    {
+        seqan::hibf::sketch::hyperloglog result{config.hibf_config.sketch_bits};
+        if (!config.hibf_config.disable_estimate_union)
+            for (size_t const pos : positions)
+                result.merge(sketches[hibf_layout.user_bins[pos].idx]);
+        return result;
+    }
+
+    //!\brief Recomputes the size of `bin`.
+    void update_size(top_level_bin & bin) const
+    {
+        if (!bin.is_merged)
+        {
+            bin.size = split_size(bin.members[0], bin.number_of_tbs);
+            return;
+        }
+
+        bin.sketch = union_of(bin.members);
+        bin.kmer_sum = 0u;
+        for (size_t const pos : bin.members)
+            bin.kmer_sum += kmer_counts[hibf_layout.user_bins[pos].idx];
+        bin.size = merged_size(bin.sketch, bin.kmer_sum);
+    }
+
+    void sort_by_size()
+    {
+        by_size.resize(bins.size());
+        std::iota(by_size.begin(), by_size.end(), size_t{});
+        std::ranges::stable_sort(by_size,
+                                 [this](size_t const lhs, size_t const rhs)
+                                 {
+                                     return bins[lhs].size > bins[rhs].size;
+                                 });
+    }
+
+    //!\brief The size of the largest bin other than `a` and `b`.
+    double largest_size_except(size_t const a, size_t const b) const
+    {
+        for (size_t const i : by_size)
+            if (i != a && i != b)
+                return bins[i].size;
+        return 0.0;
+    }
+
+    //!\brief Moves a user bin from the largest merged bin `a` into another merged bin.
+    bool try_move_user_bin(size_t const a, std::chrono::steady_clock::time_point const deadline)
+    {
+        top_level_bin const & source = bins[a];
+        size_t const number_of_members{source.members.size()};
+
+        if (number_of_members < 2u) // The merged bin must not become empty.
+            return false;
+
+        // The union of all members except member i is prefix[i] merged with suffix[i + 1].
+        std::vector<seqan::hibf::sketch::hyperloglog> prefix(number_of_members + 1u,
+                                                             seqan::hibf::sketch::hyperloglog{
+                                                                 config.hibf_config.sketch_bits});
+        std::vector<seqan::hibf::sketch::hyperloglog> suffix{prefix};
+
+        if (!config.hibf_config.disable_estimate_union)
+        {
+            for (size_t i = 0; i < number_of_members; ++i)
+            {
+                prefix[i + 1u] = prefix[i];
+                prefix[i + 1u].merge(sketches[hibf_layout.user_bins[source.members[i]].idx]);
+            }
+
+            for (size_t i = number_of_members; i > 0u; --i)
+            {
+                suffix[i - 1u] = suffix[i];
+                suffix[i - 1u].merge(sketches[hibf_layout.user_bins[source.members[i - 1u]].idx]);
+            }
+        }
+
+        double best_max_size{source.size};
+        size_t best_member{std::numeric_limits<size_t>::max()};
+        size_t best_target{};
+
+        for (size_t i = 0; i < number_of_members && std::chrono::steady_clock::now() < deadline; ++i)
+        {
+            auto const & user_bin = hibf_layout.user_bins[source.members[i]];
+
+            // User bins in deeper levels cannot be moved on their own.
+            if (user_bin.previous_TB_indices.size() != 1u)
+                continue;
+
+            size_t const kmer_count{kmer_counts[user_bin.idx]};
+            seqan::hibf::sketch::hyperloglog without{prefix[i]};
+            without.merge(suffix[i + 1u]);
+            double const size_without = merged_size(without, source.kmer_sum - kmer_count);
+
+            if (size_without >= best_max_size)
+                continue;
+
+            for (size_t b = 0; b < bins.size(); ++b)
+            {
+                top_level_bin const & target = bins[b];
+
+                if (b == a || !target.is_merged
+                    || target.child_tbs + user_bin.number_of_technical_bins > config.hibf_config.tmax)
+                    continue;
+
+                seqan::hibf::sketch::hyperloglog with{target.sketch};
+                if (!config.hibf_config.disable_estimate_union)
+                    with.merge(sketches[user_bin.idx]);
+                double const size_with = merged_size(with, target.kmer_sum + kmer_count);
+
+                double const max_size = std::max({size_without, size_with, largest_size_except(a, b)});
+
+                if (max_size < best_max_size)
+                {
+                    best_max_size = max_size;
+                    best_member = i;
+                    best_target = b;
+                }
+            }
+        }
+
+        if (best_member == std::numeric_limits<size_t>::max())
+            return false;
+
+        move_user_bin(a, best_member, best_target);
+        return true;
+    }
+
+    //!\brief Moves the member `member` of the merged bin `a` into the lower-level IBF of the merged bin `b`.
+    void move_user_bin(size_t const a, size_t const member, size_t const b)
+    {
+        top_level_bin & source = bins[a];
+        top_level_bin & target = bins[b];
+
+        size_t const pos{source.members[member]};
+        auto & moved = hibf_layout.user_bins[pos];
+        size_t const freed_tb{moved.storage_TB_id};
+        size_t const freed_tbs{moved.number_of_technical_bins};
+
+        // Close the gap in the lower-level IBF of the source.
+        source.members.erase(source.members.begin() + member);
+        for (size_t const other_pos : source.members)
+        {
+            auto & other = hibf_layout.user_bins[other_pos];
+            size_t & child_tb = other.previous_TB_indices.size() == 1u ? other.storage_TB_id
+                                                                       : other.previous_TB_indices[1];
+            if (child_tb > freed_tb)
+                child_tb -= freed_tbs;
+        }
+
+        for (auto & max_bin : hibf_layout.max_bins)
+            if (max_bin.previous_TB_indices.size() >= 2u && max_bin.previous_TB_indices[0] == source.first_tb
+                && max_bin.previous_TB_indices[1] > freed_tb)
+                max_bin.previous_TB_indices[1] -= freed_tbs;
+
+        source.child_tbs -= freed_tbs;
+
+        // Append the user bin to the lower-level IBF of the target.
+        moved.previous_TB_indices = {target.first_tb};
+        moved.storage_TB_id = target.child_tbs;
+        target.child_tbs += freed_tbs;
+        target.members.push_back(pos);
+
+        update_size(source);
+        update_size(target);
+        update_child_max_bin(source);
+        update_child_max_bin(target);
+    }
+
+    //!\brief Sets the maximum bin of the lower-level IBF of the merged bin `bin`.
+    void update_child_max_bin(top_level_bin const & bin)
+    {
+        double max_size{-1.0};
+        size_t max_id{};
+
+        // The members in deeper levels, by their technical bin in the lower-level IBF.
+        std::map<size_t, std::vector<size_t>> deeper_members{};
+
+        for (size_t const pos : bin.members)
+        {
+            auto const & user_bin = hibf_layout.user_bins[pos];
+
+            if (user_bin.previous_TB_indices.size() == 1u)
+            {
+                double const size = split_size(pos, user_bin.number_of_technical_bins);
+                if (size > max_size)
+                {
+                    max_size = size;
+                    max_id = user_bin.storage_TB_id;
+                }
+            }
+            else
+            {
+                deeper_members[user_bin.previous_TB_indices[1]].push_back(pos);
+            }
+        }
+
+        for (auto const & [child_tb, positions] : deeper_members)
+        {
+            size_t kmer_sum{};
+            for (size_t const pos : positions)
+                kmer_sum += kmer_counts[hibf_layout.user_bins[pos].idx];
+
+            double const size = merged_size(union_of(positions), kmer_sum);
+            if (size > max_size)
+            {
+                max_size = size;
+                max_id = child_tb;
+            }
+        }
+
+        std::vector<size_t> const previous_TB_indices{bin.first_tb};
+        auto it = std::ranges::find(hibf_layout.max_bins,
+                                    previous_TB_indices,
+                                    &seqan::hibf::layout::layout::max_bin::previous_TB_indices);
+
+        if (it == hibf_layout.max_bins.end())
+            hibf_layout.max_bins.push_back({.previous_TB_indices = previous_TB_indices, .id = max_id});
+        else
+            it->id = max_id;
+    }
+
+    //!\brief Gives the largest split bin `s` one more technical bin.
+    bool try_add_technical_bin(size_t const s)
+    {
+        top_level_bin const & split = bins[s];
+
+        if (split.number_of_tbs >= config.hibf_config.tmax)
+            return false;
+
+        double const grown_size = split_size(split.members[0], split.number_of_tbs + 1u);
+
+        // The memory of the top-level IBF is its largest technical bin times its number of technical bins.
+        double best_memory{split.size * used_tbs};
+        size_t best_donor{std::numeric_limits<size_t>::max()};
+        bool use_unused_tb{false};
+
+        if (used_tbs < config.hibf_config.tmax)
+        {
+            double const memory = std::max(grown_size, largest_size_except(s, s)) * (used_tbs + 1u);
+            if (memory < best_memory)
+            {
+                best_memory = memory;
+                use_unused_tb = true;
+            }
+        }
+
+        for (size_t t = 0; t < bins.size(); ++t)
+        {
+            top_level_bin const & donor = bins[t];
+
+            // Pinned user bins keep their technical bins.
+            if (t == s || donor.is_merged || donor.is_pinned || donor.number_of_tbs < 2u)
+                continue;
+
+            double const shrunk_size = split_size(donor.members[0], donor.number_of_tbs - 1u);
+            double const memory = std::max({grown_size, shrunk_size, largest_size_except(s, t)}) * used_tbs;
+
+            if (memory < best_memory)
+            {
+                best_memory = memory;
+                best_donor = t;
+                use_unused_tb = false;
+            }
+        }
+
+        if (!use_unused_tb && best_donor == std::numeric_limits<size_t>::max())
+            return false;
+
+        ++bins[s].number_of_tbs;
+        update_size(bins[s]);
+
+        if (use_unused_tb)
+        {
+            ++used_tbs;
+        }
+        else
+        {
+            --bins[best_donor].number_of_tbs;
+            update_size(bins[best_donor]);
+        }
+
+        renumber_top_level();
+        return true;
+    }
+
+    //!\brief Assigns consecutive technical bin ids to the bins of the top-level IBF after their sizes changed.
+    void renumber_top_level()
+    {
+        size_t const max_first_tb{bins.back().first_tb};
+        std::vector<size_t> new_first_tb(max_first_tb + 1u);
+
+        size_t next_tb{};
+        for (top_level_bin & bin : bins)
+        {
+            new_first_tb[bin.first_tb] = next_tb;
+            bin.first_tb = next_tb;
+            next_tb += bin.number_of_tbs;
+
+            if (!bin.is_merged)
+            {
+                auto & user_bin = hibf_layout.user_bins[bin.members[0]];
+                user_bin.storage_TB_id = bin.first_tb;
+                user_bin.number_of_technical_bins = bin.number_of_tbs;
+            }
+        }
+
+        for (auto & user_bin : hibf_layout.user_bins)
+            if (!user_bin.previous_TB_indices.empty())
+                user_bin.previous_TB_indices[0] = new_first_tb[user_bin.previous_TB_indices[0]];
+
+        for (auto & max_bin : hibf_layout.max_bins)
+            if (!max_bin.previous_TB_indices.empty())
+                max_bin.previous_TB_indices[0] = new_first_tb[max_bin.previous_TB_indices[0]];
+    }
+};
+
+refinement_result refine_layout(configuration const & config,
+                                seqan::hibf::layout::layout & hibf_layout,
+                                std::vector<size_t> const & kmer_counts,
+                                std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                std::vector<size_t> const & priorities)
+{
+    return layout_refinement{config, hibf_layout, kmer_counts, sketches, priorities}.run();
+}
+
+} // namespace chopper::layout
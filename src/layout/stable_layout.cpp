@@ -0,0 +1,384 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/hibf_statistics.hpp>
+#include <chopper/layout/input.hpp>
+#include <chopper/layout/layout_diff.hpp>
+#include <chopper/layout/stable_layout.hpp>
+
+#include <hibf/layout/compute_fpr_correction.hpp>
+#include <hibf/layout/compute_relaxed_fpr_correction.hpp>
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+void update_max_bins(configuration const & config,
+                     seqan::hibf::layout::layout & hibf_layout,
+                     std::vector<size_t> const & kmer_counts,
+                     std::vector<seqan::hibf::sketch::hyperloglog> const & sketches)
+{
+    std::vector<double> const fpr_correction =
+        seqan::hibf::layout::compute_fpr_correction({.fpr = config.hibf_config.maximum_fpr,
+                                                     .hash_count = config.hibf_config.number_of_hash_functions,
+                                                     .t_max = config.hibf_config.tmax});
+    double const relaxed_fpr_correction{seqan::hibf::layout::compute_relaxed_fpr_correction(
+        {.fpr = config.hibf_config.maximum_fpr,
+         .relaxed_fpr = config.hibf_config.relaxed_fpr,
+         .hash_count = config.hibf_config.number_of_hash_functions})};
+
+    // The user bins below each IBF, by the path of technical bins to it.
+    std::map<std::vector<size_t>, std::vector<size_t>> members{};
+
+    for (size_t pos = 0; pos < hibf_layout.user_bins.size(); ++pos)
+    {
+        auto const & previous_TB_indices = hibf_layout.user_bins[pos].previous_TB_indices;
+
+        for (size_t level = 0; level <= previous_TB_indices.size(); ++level)
+            members[{previous_TB_indices.begin(), previous_TB_indices.begin() + level}].push_back(pos);
+    }
+
+    hibf_layout.max_bins.clear();
+
+    for (auto const & [path, positions] : members)
+    {
+        size_t const level{path.size()};
+        double max_size{-1.0};
+        size_t max_id{};
+
+        // The user bins in deeper levels, by their technical bin in this IBF.
+        std::map<size_t, std::vector<size_t>> merged_bins{};
+
+        for (size_t const pos : positions)
+        {
+            auto const & user_bin = hibf_layout.user_bins[pos];
+
+            if (user_bin.previous_TB_indices.size() > level)
+            {
+                merged_bins[user_bin.previous_TB_indices[level]].push_back(user_bin.idx);
+                continue;
+            }
+
+            size_t const number_of_tbs{user_bin.number_of_technical_bins};
+            double const size =
+                static_cast<double>(kmer_counts[user_bin.idx]) / number_of_tbs * fpr_correction[number_of_tbs];
+            if (size > max_size)
+            {
+                max_size = size;
+                max_id = user_bin.storage_TB_id;
+            }
+        }
+
+        for (auto const & [tb, user_bin_indices] : merged_bins)
+        {
+            double size{};
+
+            if (config.hibf_config.disable_estimate_union)
+            {
+                for (size_t const idx : user_bin_indices)
+                    size += kmer_counts[idx];
+            }
+            else
+            {
+                seqan::hibf::sketch::hyperloglog sketch{config.hibf_config.sketch_bits};
+                for (size_t const idx : user_bin_indices)
+                    sketch.merge(sketches[idx]);
+                size = sketch.estimate();
+            }
+
+            size *= relaxed_fpr_correction;
+            if (size > max_size)
+            {
+                max_size = size;
+                max_id = tb;
+            }
+        }
+
+        if (path.empty())
+            hibf_layout.top_level_max_bin_id = max_id;
+        else
+            hibf_layout.max_bins.push_back({.previous_TB_indices = path, .id = max_id});
+    }
+}
+
+//!\brief Whether the IBF at the end of `path` holds `user_bin`, directly or in a merged bin.
+static bool is_below(seqan::hibf::layout::layout::user_bin const & user_bin, std::vector<size_t> const & path)
+{
+    auto const & indices = user_bin.previous_TB_indices;
+    return indices.size() >= path.size() && std::ranges::equal(path, indices | std::views::take(path.size()));
+}
+
+//!\brief Returns a technical bin of the IBF at the end of `path` that holds no user bin, if there is one.
+static std::optional<size_t> unused_technical_bin(seqan::hibf::layout::layout const & hibf_layout,
+                                                  std::vector<size_t> const & path,
+                                                  size_t const t_max)
+{
+    std::vector<bool> is_used(t_max, false);
+
+    for (auto const & user_bin : hibf_layout.user_bins)
+    {
+        if (!is_below(user_bin, path))
+            continue;
+
+        if (user_bin.previous_TB_indices.size() == path.size())
+            std::fill_n(is_used.begin() + user_bin.storage_TB_id, user_bin.number_of_technical_bins, true);
+        else
+            is_used[user_bin.previous_TB_indices[path.size()]] = true;
+    }
+
+    auto const it = std::ranges::find(is_used, false);
+    return it == is_used.end() ? std::nullopt : std::optional<size_t>{std::ranges::distance(is_used.begin(), it)};
+}
+
+/*!\brief Takes the last technical bin of a split bin in the IBF at the end of `path`, if there is one.
+ * \details
+ * Of all user bins that are split into at least two technical bins and are not pinned, the one whose technical bins
+ * grow the least by losing a technical bin gives up its last technical bin.
+ */
+static std::optional<size_t> take_technical_bin(seqan::hibf::layout::layout & hibf_layout,
+                                                std::vector<size_t> const & path,
+                                                std::vector<size_t> const & kmer_counts,
+                                                std::vector<size_t> const & priorities,
+                                                std::vector<double> const & fpr_correction)
+{
+    seqan::hibf::layout::layout::user_bin * donor{nullptr};
+    double donor_size{};
+
+    for (auto & user_bin : hibf_layout.user_bins)
+    {
+        size_t const number_of_tbs{user_bin.number_of_technical_bins};
+        bool const is_pinned = user_bin.idx < priorities.size() && priorities[user_bin.idx] > 0u;
+
+        if (user_bin.previous_TB_indices != path || number_of_tbs < 2u || is_pinned)
+            continue;
+
+        double const size =
+            static_cast<double>(kmer_counts[user_bin.idx]) / (number_of_tbs - 1u) * fpr_correction[number_of_tbs - 1u];
+        if (donor == nullptr || size < donor_size)
+        {
+            donor = &user_bin;
+            donor_size = size;
+        }
+    }
+
+    if (donor == nullptr)
+        return std::nullopt;
+
+    --donor->number_of_technical_bins;
+    return donor->storage_TB_id + donor->number_of_technical_bins;
+}
+
+std::optional<seqan::hibf::layout::layout>
+carry_over_layout(configuration const & config,
+                  std::vector<std::vector<std::string>> const & previous_filenames,
+                  seqan::hibf::layout::layout const & previous_layout,
+                  std::vector<std::vector<std::string>> const & filenames,
+                  std::vector<size_t> const & kmer_counts,
+                  std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                  std::vector<size_t> const & priorities)
+{
+    size_t const t_max{config.hibf_config.tmax};
+
+    // User bins are identified by their filenames. If two user bins share their filenames, they cannot be told apart.
+    std::unordered_map<std::string, seqan::hibf::layout::layout::user_bin const *> previous_user_bins{};
+    for (auto const & user_bin : previous_layout.user_bins)
+        if (!previous_user_bins.emplace(user_bin_key(previous_filenames[user_bin.idx]), &user_bin).second)
+            return std::nullopt;
+
+    seqan::hibf::layout::layout result{};
+    std::vector<size_t> new_user_bins{};
+    std::unordered_set<std::string> keys{};
+
+    for (size_t idx = 0; idx < filenames.size(); ++idx)
+    {
+        std::string key{user_bin_key(filenames[idx])};
+        auto it = previous_user_bins.find(key);
+
+        if (!keys.insert(std::move(key)).second)
+            return std::nullopt;
+
+        if (it == previous_user_bins.end())
+        {
+            new_user_bins.push_back(idx);
+            continue;
+        }
+
+        seqan::hibf::layout::layout::user_bin user_bin = *it->second;
+        user_bin.idx = idx;
+
+        bool const is_pinned = idx < priorities.size() && priorities[idx] > 0u;
+        if (is_pinned && !user_bin.previous_TB_indices.empty())
+            return std::nullopt;
+
+        if (user_bin.storage_TB_id + user_bin.number_of_technical_bins > t_max
+            || std::ranges::any_of(user_bin.previous_TB_indices,
+                                   [t_max](size_t const tb)
+                                   {
+                                       return tb >= t_max;
+                                   }))
+            return std::nullopt;
+
+        result.user_bins.push_back(std::move(user_bin));
+    }
+
+    std::vector<double> const fpr_correction =
+        seqan::hibf::layout::compute_fpr_correction({.fpr = config.hibf_config.maximum_fpr,
+                                                     .hash_count = config.hibf_config.number_of_hash_functions,
+                                                     .t_max = t_max});
+
+    // The user bins of each merged bin of the top-level IBF, by its technical bin.
+    std::map<size_t, std::vector<size_t>> merged_bins{};
+    for (auto const & user_bin : result.user_bins)
+        if (!user_bin.previous_TB_indices.empty())
+            merged_bins[user_bin.previous_TB_indices[0]].push_back(user_bin.idx);
+
+    // How much the merged bin grows by adding the user bin `idx`. Ties prefer the smaller merged bin.
+    auto growth_of = [&](std::vector<size_t> const & user_bin_indices, size_t const idx)
+    {
+        double size{};
+        double grown_size{};
+
+        if (config.hibf_config.disable_estimate_union)
+        {
+            for (size_t const member : user_bin_indices)
+                size += kmer_counts[member];
+            grown_size = size + kmer_counts[idx];
+        }
+        else
+        {
+            seqan::hibf::sketch::hyperloglog sketch{config.hibf_config.sketch_bits};
+            for (size_t const member : user_bin_indices)
+                sketch.merge(sketches[member]);
+            size = sketch.estimate();
+            sketch.merge(sketches[idx]);
+            grown_size = sketch.estimate();
+        }
+
+        return std::pair{grown_size - size, size};
+    };
+
+    // Each new user bin gets, in this order,
+    // 1. a technical bin of the top-level IBF that is not used by any other user bin,
+    // 2. a technical bin in the lower-level IBF of the merged bin it is most similar to, or
+    // 3. the last technical bin of a split bin of the top-level IBF.
+    for (size_t const idx : new_user_bins)
+    {
+        std::optional<size_t> tb = unused_technical_bin(result, {}, t_max);
+
+        if (tb)
+        {
+            result.user_bins.push_back(
+                {.previous_TB_indices = {}, .storage_TB_id = *tb, .number_of_technical_bins = 1u, .idx = idx});
+            continue;
+        }
+
+        std::vector<std::pair<std::pair<double, double>, size_t>> closest_merged_bins{};
+        for (auto const & [merged_tb, user_bin_indices] : merged_bins)
+            closest_merged_bins.emplace_back(growth_of(user_bin_indices, idx), merged_tb);
+        std::ranges::sort(closest_merged_bins);
+
+        for (auto const & [growth, merged_tb] : closest_merged_bins)
+        {
+            std::vector<size_t> const path{merged_tb};
+
+            tb = unused_technical_bin(result, path, t_max);
+            if (!tb)
+                tb = take_technical_bin(result, path, kmer_counts, priorities, fpr_correction);
+
+            if (tb)
+            {
+                result.user_bins.push_back(
+                    {.previous_TB_indices = path, .storage_TB_id = *tb, .number_of_technical_bins = 1u, .idx = idx});
+                merged_bins[merged_tb].push_back(idx);
+                break;
+            }
+        }
+
+        if (tb)
+            continue;
+
+        tb = take_technical_bin(result, {}, kmer_counts, priorities, fpr_correction);
+
+        if (!tb)
+            return std::nullopt;
+
+        result.user_bins.push_back(
+            {.previous_TB_indices = {}, .storage_TB_id = *tb, .number_of_technical_bins = 1u, .idx = idx});
+    }
+
+    std::ranges::sort(result.user_bins, {}, &seqan::hibf::layout::layout::user_bin::idx);
+    update_max_bins(config, result, kmer_counts, sketches);
+
+    return result;
+}
+
+stabilization_result stabilize_layout(configuration const & config,
+                                      seqan::hibf::layout::layout & hibf_layout,
+                                      std::vector<std::vector<std::string>> const & filenames,
+                                      std::vector<size_t> const & kmer_counts,
+                                      std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                      std::vector<size_t> const & priorities)
+{
+    std::ifstream layout_file{config.previous_layout};
+    if (!layout_file.good() || !layout_file.is_open())
+        throw std::runtime_error{"Could not open previous layout " + config.previous_layout.string()
+                                 + " for reading."};
+
+    auto const previous = read_layout_file(layout_file);
+    std::vector<std::vector<std::string>> const & previous_filenames = std::get<0>(previous);
+    seqan::hibf::layout::layout const & previous_layout = std::get<2>(previous);
+
+    auto cost_of = [&](seqan::hibf::layout::layout const & candidate, size_t & size, double & rebuilt_fraction)
+    {
+        hibf_statistics stats{config, sketches, kmer_counts};
+        stats.hibf_layout = candidate;
+        size = stats.total_hibf_size_in_byte();
+        rebuilt_fraction =
+            diff_layouts(previous_filenames, previous_layout, filenames, candidate, kmer_counts).rebuilt_fraction();
+        return size * (1.0 + config.move_penalty * rebuilt_fraction);
+    };
+
+    stabilization_result result{};
+    double const cost = cost_of(hibf_layout, result.size, result.rebuilt_fraction);
+
+    std::optional<seqan::hibf::layout::layout> carried_over =
+        carry_over_layout(config, previous_filenames, previous_layout, filenames, kmer_counts, sketches, priorities);
+
+    if (!carried_over)
+        return result;
+
+    double const carried_over_cost =
+        cost_of(*carried_over, result.alternative_size, result.alternative_rebuilt_fraction);
+
+    if (carried_over_cost <= cost)
+    {
+        hibf_layout = std::move(*carried_over);
+        result.kept_previous = true;
+        std::swap(result.size, result.alternative_size);
+        std::swap(result.rebuilt_fraction, result.alternative_rebuilt_fraction);
+    }
+
+    return result;
+}
+
+} // namespace chopper::layout
@@ -0,0 +1,136 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <exception>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/compute_layout_with_pinned_bins.hpp>
+#include <chopper/layout/hibf_statistics.hpp>
+#include <chopper/layout/number_of_levels.hpp>
+#include <chopper/layout/sweep.hpp>
+#include <chopper/layout/user_bin_fpr.hpp>
+
+#include <hibf/config.hpp>
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::layout
+{
+
+std::vector<sweep_result> sweep(configuration const & config,
+                                std::vector<size_t> const & kmer_counts,
+                                std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                std::vector<size_t> const & priorities)
+{
+    auto values_or_default = []<typename value_t>(std::vector<value_t> const & values, value_t const default_value)
+    {
+        return values.empty() ? std::vector<value_t>{default_value} : values;
+    };
+
+    seqan::hibf::config const & hibf_config{config.hibf_config};
+    std::vector<double> const fprs = values_or_default(config.sweep_fprs, hibf_config.maximum_fpr);
+    std::vector<double> const relaxed_fprs = values_or_default(config.sweep_relaxed_fprs, hibf_config.relaxed_fpr);
+    std::vector<size_t> const hash_functions =
+        values_or_default(config.sweep_hash_functions, hibf_config.number_of_hash_functions);
+    std::vector<double> const alphas = values_or_default(config.sweep_alphas, hibf_config.alpha);
+    std::vector<size_t> const tmaxs = values_or_default(config.sweep_tmaxs, hibf_config.tmax);
+
+    std::vector<sweep_result> results{};
+    for (double const fpr : fprs)
+        for (double const relaxed_fpr : relaxed_fprs)
+            for (size_t const hash_count : hash_functions)
+                for (double const alpha : alphas)
+                    for (size_t const tmax : tmaxs)
+                        results.push_back({.fpr = fpr,
+                                           .relaxed_fpr = relaxed_fpr,
+                                           .hash_functions = hash_count,
+                                           .alpha = alpha,
+                                           .tmax = tmax});
+
+    std::vector<std::exception_ptr> errors(results.size());
+
+#pragma omp parallel for schedule(dynamic) num_threads(hibf_config.threads)
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        sweep_result & result = results[i];
+
+        try
+        {
+            configuration local_config{config};
+            local_config.hibf_config.maximum_fpr = result.fpr;
+            use_strictest_fpr(local_config); // User bins with a stricter FPR keep it.
+            result.fpr = local_config.hibf_config.maximum_fpr;
+            local_config.hibf_config.relaxed_fpr = result.relaxed_fpr;
+            local_config.hibf_config.number_of_hash_functions = result.hash_functions;
+            local_config.hibf_config.alpha = result.alpha;
+            local_config.hibf_config.tmax = result.tmax;
+            local_config.hibf_config.threads = 1u; // The combinations are already computed in parallel.
+
+            seqan::hibf::layout::layout hibf_layout{};
+
+            try
+            {
+                local_config.hibf_config.validate_and_set_defaults();
+                hibf_layout = compute_layout_with_pinned_bins(local_config, kmer_counts, sketches, priorities);
+            }
+            catch (std::invalid_argument const &)
+            {
+                continue; // Invalid parameters or the pinned user bins do not fit. Reported as not valid.
+            }
+
+            hibf_statistics stats{local_config, sketches, kmer_counts};
+            stats.hibf_layout = hibf_layout;
+            stats.finalize();
+
+            result.tmax = local_config.hibf_config.tmax; // A tmax of 0 is replaced by the default.
+            result.valid = true;
+            result.levels = number_of_levels(hibf_layout);
+            result.size_in_bytes = stats.total_hibf_size_in_byte();
+            result.expected_query_cost = stats.expected_HIBF_query_cost;
+        }
+        catch (...)
+        {
+            errors[i] = std::current_exception(); // Exceptions must not leave the parallel region.
+        }
+    }
+
+    // The error of the first failing combination is reported, independent of the number of threads.
+    for (std::exception_ptr const & error : errors)
+        if (error)
+            std::rethrow_exception(error);
+
+    return results;
+}
+
+void write_sweep_table_to(std::ostream & stream, std::vector<sweep_result> const & results)
+{
+    stream << "# fpr\trelaxed_fpr\thash\talpha\ttmax\tlevels\tsize_in_bytes\tsize\texpected_query_cost\n";
+
+    for (sweep_result const & result : results)
+    {
+        stream << result.fpr << '\t' << result.relaxed_fpr << '\t' << result.hash_functions << '\t' << result.alpha
+               << '\t' << result.tmax << '\t';
+
+        if (!result.valid)
+        {
+            stream << "NA\tNA\tNA\tNA\n";
+            continue;
+        }
+
+        stream << result.levels << '\t' << result.size_in_bytes << '\t'
+               << hibf_statistics::byte_size_to_formatted_str(result.size_in_bytes) << '\t' << std::fixed
+               << std::setprecision(4) << result.expected_query_cost << std::defaultfloat << std::setprecision(6)
+               << '\n';
+    }
+}
+
+} // namespace chopper::layout
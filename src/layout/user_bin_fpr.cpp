@@ -0,0 +1,47 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/user_bin_fpr.hpp>
+
+namespace chopper::layout
+{
+
+void use_strictest_fpr(configuration & config)
+{
+    if (config.hibf_config.number_of_user_bins == 0u)
+        return;
+
+    // --fpr only counts if some user bins have no FPR of their own.
+    double strictest_fpr{user_bin_fpr(config, 0u)};
+    for (size_t idx = 1u; idx < config.hibf_config.number_of_user_bins; ++idx)
+        strictest_fpr = std::min(strictest_fpr, user_bin_fpr(config, idx));
+
+    config.hibf_config.maximum_fpr = strictest_fpr;
+}
+
+std::vector<std::vector<size_t>> fpr_classes(configuration const & config)
+{
+    std::map<double, std::vector<size_t>> user_bins_by_fpr{};
+    for (size_t idx = 0; idx < config.hibf_config.number_of_user_bins; ++idx)
+        user_bins_by_fpr[user_bin_fpr(config, idx)].push_back(idx);
+
+    std::vector<std::vector<size_t>> result{};
+    result.reserve(user_bins_by_fpr.size());
+    for (auto & [fpr, user_bins] : user_bins_by_fpr)
+        result.push_back(std::move(user_bins));
+
+    return result;
+}
+
+} // namespace chopper::layout
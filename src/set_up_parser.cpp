@@ -16,6 +16,22 @@
 namespace chopper
 {
 
+//!\brief Adds --similarity-neighbours, which is shared by the layout, sketch and merge-sketches parsers.
+static void add_similarity_neighbours_option(sharg::parser & parser, configuration & config)
+{
+    parser.add_option(
+        config.similarity_neighbours,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "similarity-neighbours",
+            .description =
+                "If greater than 0, the given number of most similar user bins of each user bin is estimated from "
+                "the sketches and written next to the sketch file (with the extension \".similarities\"). Later runs "
+                "that use the same sketch file load the similarities instead of recomputing them. For more than 4096 "
+                "user bins, only pairs of user bins found by locality-sensitive hashing are compared.",
+            .advanced = true});
+}
+
 void set_up_parser(sharg::parser & parser, configuration & config)
 {
     parser.info.version = "1.0.0";
@@ -150,8 +166,10 @@ void set_up_parser(sharg::parser & parser, configuration & config)
             .short_id = '\0',
             .long_id = "threads",
             .description =
-                "The number of threads to use. Currently, only merging of sketches is parallelized, so if the flag "
-                "--disable-rearrangement is set, --threads will have no effect.",
+                "The number of threads to use. Sketching is parallelized over all files of all user bins. "
+                "Merging of sketches is parallelized only if the flag --disable-rearrangement is not set. "
+                "With --group-size, the layouts of the groups are computed in parallel. The layout does not depend "
+                "on the number of threads.",
             .validator =
                 sharg::arithmetic_range_validator{static_cast<size_t>(1), std::numeric_limits<size_t>::max()}});
 
@@ -245,6 +263,149 @@ void set_up_parser(sharg::parser & parser, configuration & config)
                 "ignored and has no effect.",
             .advanced = true});
 
+    parser.add_option(
+        config.query_cost_weight,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "query-cost-weight",
+            .description =
+                "When determining the best tmax, layouts are compared by query_cost^w * memory^(1-w), where w is the "
+                "given weight and both query cost and memory are relative to tmax=64. The default of 1 only "
+                "considers the expected query cost, 0 only considers the memory. Setting this option implies "
+                "--determine-best-tmax.",
+            .advanced = true,
+            .validator = sharg::arithmetic_range_validator{0.0, 1.0}});
+
+    parser.add_option(
+        config.query_cost_table,
+        sharg::config{.short_id = '\0',
+                      .long_id = "query-cost-table",
+                      .description =
+                          "A query cost table computed by \\fBchopper calibrate\\fP. It replaces the built-in table "
+                          "that was measured on different hardware and is used to compute the expected query cost.",
+                      .default_message = "None",
+                      .advanced = true,
+                      .validator = sharg::input_file_validator{}});
+
+    parser.add_option(
+        config.max_levels,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "max-levels",
+            .description =
+                "The maximum number of levels of the HIBF, i.e. the maximum number of IBFs a query has to look up. "
+                "If the layout for --tmax has more levels, tmax is doubled until the layout has at most "
+                "--max-levels levels. With --determine-best-tmax, only layouts with at most --max-levels levels are "
+                "considered. The statistics report how much memory the limit costs. 0 means no limit.",
+            .advanced = true});
+
+    parser.add_option(
+        config.group_size,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "group-size",
+            .description =
+                "For very many user bins. If there are more user bins, they are divided into groups of at most this "
+                "many user bins, whose layouts are computed independently and in parallel. Each group becomes a "
+                "merged bin of the top-level IBF. Similar user bins are grouped together, using the similarities of a "
+                "sketch file (see --similarity-neighbours) if available. 0 computes a single layout.",
+            .default_message = "0",
+            .advanced = true});
+
+    parser.add_option(
+        config.number_of_partitions,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "partitions",
+            .description =
+                "Divides the user bins into the given number of independent layouts, e.g. to distribute the index "
+                "over several machines. Similar user bins are put into the same layout, and the layouts have similar "
+                "predicted index sizes. The layouts are written to files named after --output with the number of "
+                "the partition before the extension, e.g. layout.0.txt, layout.1.txt, etc. User bins with different "
+                "false positive rates (see fpr= in the data file) are always written to different layouts.",
+            .default_message = "1",
+            .advanced = true,
+            .validator = sharg::arithmetic_range_validator{1, 65536}});
+
+    parser.add_option(
+        config.max_memory,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "max-memory",
+            .description =
+                "The memory available for computing the layout, e.g. \"64G\". The units K, M, G, T and P are powers "
+                "of 1024. If the layout algorithm would need more memory for all user bins, they are divided into "
+                "groups as with --group-size, such that all groups computed at once (see --threads) fit into the "
+                "given memory.",
+            .default_message = "None",
+            .advanced = true});
+
+    parser.add_option(
+        config.refinement_time,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "refinement-time",
+            .description =
+                "The time in seconds to refine the layout after it was computed. The refinement moves user bins "
+                "between merged bins and technical bins between split bins of the top-level IBF as long as this "
+                "shrinks its largest technical bin, which determines the size of the IBF. 0 disables it.",
+            .default_message = "0",
+            .advanced = true,
+            .validator = sharg::arithmetic_range_validator{0.0, 86400.0}});
+
+    parser.add_option(
+        config.previous_layout,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "previous-layout",
+            .description =
+                "A layout file of a previous run, e.g. before user bins were added or removed. User bins keep their "
+                "technical bins of the previous layout, and new user bins are added to the top-level IBF, if this "
+                "costs less than the new layout. The cost of a layout is its size plus the cost of rebuilding its "
+                "changed IBFs (see --move-penalty). Unchanged IBFs of the previous index can be reused.",
+            .advanced = true,
+            .validator = sharg::input_file_validator{}});
+
+    parser.add_option(
+        config.move_penalty,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "move-penalty",
+            .description =
+                "The cost of rebuilding the whole index as a fraction of its size, used with --previous-layout. For "
+                "example, with 0.2, a new layout that changes all IBFs is only used if it is more than 20% smaller.",
+            .default_message = "0.2",
+            .advanced = true,
+            .validator = sharg::arithmetic_range_validator{0.0, 100.0}});
+
+    parser.add_option(
+        config.max_index_size,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "max-index-size",
+            .description =
+                "The maximum size of the index, e.g. \"400G\". The units K, M, G, T and P are powers of 1024. "
+                "Searches the lowest false positive rate (and the best number of hash functions and tmax for it) "
+                "whose layout fits into the given size. The values of --fpr, --relaxed-fpr and --hash are replaced "
+                "by the result; --tmax remains the upper bound for tmax. Setting this option implies "
+                "--determine-best-tmax.",
+            .default_message = "None",
+            .advanced = true});
+
+    parser.add_option(
+        config.query_sample,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "query-sample",
+            .description =
+                "A sample of the expected queries (sequence file or .minimiser file). By default, the expected query "
+                "cost assumes that all k-mers of the input are queried equally often. With a query sample, each "
+                "user bin is weighted by the estimated number of k-mers it shares with the sample instead. "
+                "Setting this option implies --determine-best-tmax.",
+            .default_message = "None",
+            .advanced = true,
+            .validator = sharg::input_file_validator{}});
+
     parser.add_flag(
         config.output_verbose_statistics,
         sharg::config{.short_id = '\0',
@@ -265,6 +426,8 @@ void set_up_parser(sharg::parser & parser, configuration & config)
             .default_message = "None",
             .advanced = true});
 
+    add_similarity_neighbours_option(parser, config);
+
     parser.add_flag(config.debug,
                     sharg::config{.short_id = '\0',
                                   .long_id = "debug",
@@ -277,4 +440,270 @@ void set_up_parser(sharg::parser & parser, configuration & config)
                     "les Pins, France. pp.137-156. hal-00406166v2, https://doi.org/10.46298/dmtcs.3545");
 }
 
+void set_up_sketch_parser(sharg::parser & parser, configuration & config)
+{
+    parser.info.version = "1.0.0";
+    parser.info.author = "Svenja Mehringer";
+    parser.info.email = "svenja.mehringer@fu-berlin.de";
+    parser.info.short_description = "Compute the HyperLogLog sketches of (a shard of) the input";
+
+    parser.info.description.emplace_back(
+        "Computes the HyperLogLog sketches of the user bins and writes them to a sketch file. No layout is computed. "
+        "The data file can be split into shards that are sketched independently, e.g., by separate jobs on a "
+        "cluster. The resulting sketch files are combined with \\fBchopper merge-sketches\\fP and the combined "
+        "sketch file is passed to \\fBchopper layout\\fP.");
+
+    parser.info.synopsis.emplace_back(
+        "chopper sketch --input <file> --output <file> [--shard <i/n>] [--threads <number>] [--kmer <number>]");
+
+    parser.add_option(config.data_file,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "input",
+                                    .description = "A file containing paths to sequence data; one filepath per line.",
+                                    .required = true,
+                                    .validator = sharg::input_file_validator{}});
+
+    parser.add_option(config.sketch_directory,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "output",
+                                    .description = "The sketch file to write. The file extension must be \".sketch\" "
+                                                   "or \".sketches\".",
+                                    .required = true});
+
+    parser.add_option(
+        config.shard,
+        sharg::config{.short_id = '\0',
+                      .long_id = "shard",
+                      .description =
+                          "Only sketch the i-th of n contiguous blocks of the input (0-based), given as \"i/n\". "
+                          "Concatenating all shards in order yields the same user bins as sketching the whole input."});
+
+    parser.add_flag(
+        config.shard_by_hash,
+        sharg::config{.short_id = '\0',
+                      .long_id = "shard-by-hash",
+                      .description =
+                          "Assign each line of the input to a shard by hashing its filenames instead of splitting the "
+                          "input into contiguous blocks. This spreads large neighbouring files over the shards. "
+                          "The original order is restored by \\fBchopper merge-sketches\\fP."});
+
+    parser.add_option(config.k,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "kmer",
+                                    .description = "The k-mer size. See \\fBchopper --help\\fP."});
+
+    parser.add_option(config.window_size,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "window",
+                                    .description = "The window size. See \\fBchopper --help\\fP.",
+                                    .default_message = "k-mer size"});
+
+    parser.add_option(
+        config.hibf_config.threads,
+        sharg::config{
+            .short_id = '\0',
+            .long_id = "threads",
+            .description = "The number of threads to use. Sketching is parallelized over all files of all user bins.",
+            .validator =
+                sharg::arithmetic_range_validator{static_cast<size_t>(1), std::numeric_limits<size_t>::max()}});
+
+    parser.add_option(
+        config.hibf_config.sketch_bits,
+        sharg::config{.short_id = '\0',
+                      .long_id = "sketch-bits",
+                      .description =
+                          "The number of bits the HyperLogLog sketch should use to distribute the values into bins.",
+                      .advanced = true,
+                      .validator = sharg::arithmetic_range_validator{5, 32}});
+
+    add_similarity_neighbours_option(parser, config);
+
+    parser.add_option(config.output_timings,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "timing-output",
+                                    .description = "Write time and memory usage to specified file (TSV format). ",
+                                    .default_message = "",
+                                    .validator = sharg::output_file_validator{}});
+}
+
+void set_up_merge_sketches_parser(sharg::parser & parser, configuration & config)
+{
+    parser.info.version = "1.0.0";
+    parser.info.author = "Svenja Mehringer";
+    parser.info.email = "svenja.mehringer@fu-berlin.de";
+    parser.info.short_description = "Combine the sketch files of all shards";
+
+    parser.info.description.emplace_back(
+        "Combines the sketch files produced by \\fBchopper sketch --shard\\fP into a single sketch file. The "
+        "order in which the sketch files are given does not matter, but every shard must be given exactly once.");
+
+    parser.info.synopsis.emplace_back("chopper merge-sketches --input <file> [--input <file> ...] --output <file>");
+
+    parser.add_option(config.sketch_files,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "input",
+                                    .description = "A sketch file of one shard. Repeat this option for every shard.",
+                                    .required = true,
+                                    .validator = sharg::input_file_validator{}});
+
+    parser.add_option(config.sketch_directory,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "output",
+                                    .description = "The sketch file to write. The file extension must be \".sketch\" "
+                                                   "or \".sketches\".",
+                                    .required = true});
+
+    add_similarity_neighbours_option(parser, config);
+
+    parser.add_option(
+        config.hibf_config.threads,
+        sharg::config{.short_id = '\0',
+                      .long_id = "threads",
+                      .description = "The number of threads to use for --similarity-neighbours.",
+                      .validator = sharg::arithmetic_range_validator{static_cast<size_t>(1),
+                                                                     std::numeric_limits<size_t>::max()}});
+}
+
+void set_up_calibrate_parser(sharg::parser & parser, configuration & config)
+{
+    parser.info.version = "1.0.0";
+    parser.info.author = "Svenja Mehringer";
+    parser.info.email = "svenja.mehringer@fu-berlin.de";
+    parser.info.short_description = "Measure the query cost of IBFs on this machine";
+
+    parser.info.description.emplace_back(
+        "Measures how the query time of an interleaved Bloom filter grows with the number of technical bins for "
+        "different false positive rates, and writes the relative query costs to a table. Pass the table to "
+        "\\fBchopper --query-cost-table\\fP to determine the best tmax for this machine instead of using the "
+        "built-in table.");
+
+    parser.info.synopsis.emplace_back("chopper calibrate --output <file> [--max-tmax <number>] [--fpr <number> ...]");
+
+    parser.add_option(config.query_cost_table,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "output",
+                                    .description = "The query cost table to write.",
+                                    .required = true,
+                                    .validator = sharg::output_file_validator{}});
+
+    parser.add_option(config.calibration_fprs,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "fpr",
+                                    .description = "A false positive rate to measure. Repeat this option for every "
+                                                   "false positive rate.",
+                                    .default_message = "The false positive rates of the built-in table"});
+
+    parser.add_option(
+        config.calibration_max_tmax,
+        sharg::config{.short_id = '\0',
+                      .long_id = "max-tmax",
+                      .description =
+                          "The largest number of technical bins to measure. Must be a power of two. The query cost of "
+                          "larger tmax is extrapolated from the built-in table."});
+
+    parser.add_option(config.hibf_config.number_of_hash_functions,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "hash",
+                                    .description = "The number of hash functions of the IBFs.",
+                                    .validator = sharg::arithmetic_range_validator{1, 5}});
+
+    parser.add_option(config.calibration_elements,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "elements",
+                                    .description = "The number of elements inserted into each technical bin.",
+                                    .advanced = true});
+
+    parser.add_option(config.calibration_queries,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "queries",
+                                    .description = "The number of queries per measurement.",
+                                    .advanced = true});
+
+    parser.add_option(
+        config.calibration_repetitions,
+        sharg::config{.short_id = '\0',
+                      .long_id = "repetitions",
+                      .description = "Every measurement is repeated and the fastest run is kept.",
+                      .advanced = true,
+                      .validator = sharg::arithmetic_range_validator{static_cast<size_t>(1),
+                                                                     std::numeric_limits<size_t>::max()}});
+}
+
+void set_up_sweep_parser(sharg::parser & parser, configuration & config)
+{
+    parser.info.version = "1.0.0";
+    parser.info.author = "Svenja Mehringer";
+    parser.info.email = "svenja.mehringer@fu-berlin.de";
+    parser.info.short_description = "Compare layouts for a grid of parameters";
+
+    parser.info.description.emplace_back(
+        "Computes a layout of the sketch file for every combination of the given values of --fpr, --relaxed-fpr, "
+        "--hash, --alpha and --tmax and writes the number of levels, the estimated size and the expected query cost "
+        "of each layout to a tab-separated table. The sketch file is read and the k-mer counts are estimated only "
+        "once for all combinations. The combinations are computed in parallel. The layouts themselves are not "
+        "written; use \\fBchopper layout\\fP with the chosen parameters.");
+
+    parser.info.synopsis.emplace_back(
+        "chopper sweep --input <file.sketch> --output <file> [--fpr <number> ...] [--tmax <number> ...]");
+
+    parser.add_option(config.data_file,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "input",
+                                    .description = "A sketch file computed by chopper sketch or chopper layout.",
+                                    .required = true,
+                                    .validator = sharg::input_file_validator{{"sketch", "sketches"}}});
+
+    parser.add_option(config.output_filename,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "output",
+                                    .description = "The table to write.",
+                                    .required = true,
+                                    .validator = sharg::output_file_validator{}});
+
+    parser.add_option(config.sweep_fprs,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "fpr",
+                                    .description = "A maximum false positive rate. Repeat this option for every value.",
+                                    .default_message = "0.05"});
+
+    parser.add_option(config.sweep_relaxed_fprs,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "relaxed-fpr",
+                                    .description = "A relaxed false positive rate. Repeat this option for every value.",
+                                    .default_message = "0.3"});
+
+    parser.add_option(config.sweep_hash_functions,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "hash",
+                                    .description = "A number of hash functions. Repeat this option for every value.",
+                                    .default_message = "2",
+                                    .validator = sharg::arithmetic_range_validator{1, 5}});
+
+    parser.add_option(config.sweep_alphas,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "alpha",
+                                    .description = "An alpha value. Repeat this option for every value.",
+                                    .default_message = "1.2"});
+
+    parser.add_option(config.sweep_tmaxs,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "tmax",
+                                    .description = "A number of technical bins. Repeat this option for every value.",
+                                    .default_message = "≈sqrt(#samples)"});
+
+    parser.add_option(
+        config.hibf_config.threads,
+        sharg::config{.short_id = '\0',
+                      .long_id = "threads",
+                      .description = "The number of combinations to compute in parallel.",
+                      .validator = sharg::arithmetic_range_validator{static_cast<size_t>(1),
+                                                                     std::numeric_limits<size_t>::max()}});
+
+    parser.add_option(config.query_cost_table,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "query-cost-table",
+                                    .description = "A query cost table written by chopper calibrate.",
+                                    .validator = sharg::input_file_validator{}});
+}
+
 } // namespace chopper
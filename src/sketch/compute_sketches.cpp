@@ -0,0 +1,72 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/input_functor.hpp>
+#include <chopper/sketch/compute_sketches.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+void compute_sketches(configuration const & config, std::vector<sparse_hyperloglog> & sketches)
+{
+    input_functor const * const input_fn = config.hibf_config.input_fn.target<input_functor>();
+
+    if (input_fn == nullptr || input_fn->filenames == nullptr)
+        throw std::invalid_argument{"The input function must be a chopper::input_functor with filenames."};
+
+    std::vector<std::vector<std::string>> const & filenames{*input_fn->filenames};
+    size_t const number_of_user_bins{filenames.size()};
+    uint8_t const sketch_bits{config.hibf_config.sketch_bits};
+
+    sketches.assign(number_of_user_bins, sparse_hyperloglog{sketch_bits});
+
+    // One task per file. A user bin with many small files no longer runs on a single thread.
+    std::vector<std::pair<size_t, size_t>> tasks{}; // (user bin index, file index)
+    for (size_t ub = 0; ub < number_of_user_bins; ++ub)
+        for (size_t file = 0; file < filenames[ub].size(); ++file)
+            tasks.emplace_back(ub, file);
+
+    std::vector<std::mutex> user_bin_mutexes(number_of_user_bins);
+
+#pragma omp parallel num_threads(config.hibf_config.threads)
+    {
+        // Only one dense sketch per thread. The sketches of the user bins are stored sparse if they are small.
+        seqan::hibf::sketch::hyperloglog file_sketch{sketch_bits};
+
+#pragma omp for schedule(dynamic)
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            auto const [ub, file] = tasks[i];
+
+            file_sketch.reset();
+            input_fn->add_to_sketch(filenames[ub][file], file_sketch);
+            sparse_hyperloglog compressed_sketch{file_sketch};
+
+            if (filenames[ub].size() == 1u) // No other task writes to this sketch.
+            {
+                sketches[ub] = std::move(compressed_sketch);
+                continue;
+            }
+
+            std::lock_guard<std::mutex> guard{user_bin_mutexes[ub]};
+            sketches[ub].merge(compressed_sketch);
+        }
+    }
+}
+
+} // namespace chopper::sketch
@@ -0,0 +1,53 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/input_functor.hpp>
+#include <chopper/sketch/estimate_query_hits.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+std::vector<double> estimate_query_hits(configuration const & config,
+                                        std::vector<seqan::hibf::sketch::hyperloglog> const & sketches)
+{
+    chopper::input_functor const sample_input{.filenames = {},
+                                              .input_are_precomputed_files =
+                                                  config.query_sample.extension() == ".minimiser",
+                                              .kmer_size = config.k,
+                                              .window_size = config.window_size};
+
+    seqan::hibf::sketch::hyperloglog sample_sketch{config.hibf_config.sketch_bits};
+    sample_input.add_to_sketch(config.query_sample.string(), sample_sketch);
+    double const sample_estimate{sample_sketch.estimate()};
+
+    std::vector<double> hits(sketches.size());
+
+    for (size_t i = 0; i < sketches.size(); ++i)
+    {
+        seqan::hibf::sketch::hyperloglog union_sketch{sample_sketch};
+        union_sketch.merge(sketches[i]);
+        // Since the sizes are estimates, the intersection might be slightly below 0.
+        hits[i] = std::max(sample_estimate + sketches[i].estimate() - union_sketch.estimate(), 0.0);
+    }
+
+    if (std::accumulate(hits.begin(), hits.end(), 0.0) <= 0.0)
+        throw std::runtime_error{"The query sample " + config.query_sample.string()
+                                 + " does not share any k-mers with the user bins."};
+
+    return hits;
+}
+
+} // namespace chopper::sketch
@@ -0,0 +1,86 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <bit>
+#include <cassert>
+#include <cinttypes>
+#include <cmath>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <chopper/sketch/hyperloglog_registers.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+std::vector<uint8_t> registers_of(seqan::hibf::sketch::hyperloglog const & sketch)
+{
+    std::stringstream buffer{};
+    sketch.store(buffer);
+    std::string const serialised = buffer.str();
+
+    assert(serialised.size() == sketch.data_size() + 1u);
+    return std::vector<uint8_t>(serialised.begin() + 1, serialised.end());
+}
+
+seqan::hibf::sketch::hyperloglog to_hyperloglog(std::vector<uint8_t> const & registers)
+{
+    assert(std::has_single_bit(registers.size()));
+    uint8_t const bits = static_cast<uint8_t>(std::countr_zero(registers.size()));
+
+    std::string serialised(registers.size() + 1u, '\0');
+    serialised[0] = static_cast<char>(bits);
+    for (size_t i = 0; i < registers.size(); ++i)
+        serialised[i + 1u] = static_cast<char>(registers[i]);
+
+    std::stringstream buffer{serialised};
+    seqan::hibf::sketch::hyperloglog sketch{bits};
+    sketch.load(buffer);
+    return sketch;
+}
+
+hyperloglog_estimator::hyperloglog_estimator(size_t const number_of_registers) noexcept :
+    number_of_registers{number_of_registers}
+{
+    double const m = static_cast<double>(number_of_registers);
+
+    double alpha{};
+    switch (number_of_registers)
+    {
+    case 16u:
+        alpha = 0.673;
+        break;
+    case 32u:
+        alpha = 0.697;
+        break;
+    case 64u:
+        alpha = 0.709;
+        break;
+    default:
+        alpha = 0.7213 / (1.0 + 1.079 / m);
+    }
+
+    normalization_factor = alpha * m * m;
+}
+
+double hyperloglog_estimator::estimate() const noexcept
+{
+    double const m = static_cast<double>(number_of_registers);
+    double const raw_estimate = normalization_factor / sum;
+
+    // Linear counting for small cardinalities.
+    if (raw_estimate <= 2.5 * m && zeros != 0u)
+        return m * std::log(m / zeros);
+
+    return raw_estimate;
+}
+
+} // namespace chopper::sketch
@@ -0,0 +1,121 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <chopper/sketch/hyperloglog_registers.hpp>
+#include <chopper/sketch/lsh_candidates.hpp>
+#include <chopper/splitmix64.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+//!\brief Within a bucket, each user bin is paired with at most this many following user bins.
+static constexpr size_t max_pairs_per_user_bin_and_bucket{32u};
+
+//!\brief Merges the sorted and unique `other` into the sorted and unique `pairs` and frees the memory of `other`.
+static void merge_into(std::vector<std::pair<size_t, size_t>> & pairs, std::vector<std::pair<size_t, size_t>> & other)
+{
+    std::vector<std::pair<size_t, size_t>> merged{};
+    merged.reserve(pairs.size() + other.size());
+    std::ranges::set_union(pairs, other, std::back_inserter(merged));
+
+    pairs = std::move(merged);
+    other = std::vector<std::pair<size_t, size_t>>{};
+}
+
+std::vector<std::pair<size_t, size_t>>
+lsh_candidate_pairs(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                    size_t const rows_per_band,
+                    size_t const threads)
+{
+    if (rows_per_band == 0u)
+        throw std::invalid_argument{"The number of rows per band must be greater than 0."};
+
+    size_t const number_of_user_bins{sketches.size()};
+
+    if (number_of_user_bins < 2u)
+        return {};
+
+    size_t const number_of_registers{sketches[0].data_size()};
+    size_t const number_of_bands{std::max<size_t>(number_of_registers / rows_per_band, 1u)};
+
+    std::vector<std::vector<uint8_t>> registers(number_of_user_bins);
+    for (size_t i = 0; i < number_of_user_bins; ++i)
+    {
+        if (sketches[i].data_size() != number_of_registers)
+            throw std::invalid_argument{"All sketches must have the same number of registers."};
+        registers[i] = registers_of(sketches[i]);
+    }
+
+    std::vector<std::vector<std::pair<size_t, size_t>>> pairs_of_band(number_of_bands);
+
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+    for (size_t band = 0; band < number_of_bands; ++band)
+    {
+        size_t const first_row{band * rows_per_band};
+        size_t const last_row{std::min(first_row + rows_per_band, number_of_registers)};
+
+        // (hash of the band, user bin). User bins whose registers of this band are all empty are left out.
+        std::vector<std::pair<uint64_t, size_t>> buckets{};
+        buckets.reserve(number_of_user_bins);
+
+        for (size_t i = 0; i < number_of_user_bins; ++i)
+        {
+            uint64_t hash{band};
+            bool is_empty{true};
+
+            for (size_t row = first_row; row < last_row; ++row)
+            {
+                uint8_t const value = registers[i][row];
+                is_empty &= value == 0u;
+                hash = splitmix64(hash ^ value);
+            }
+
+            if (!is_empty)
+                buckets.emplace_back(hash, i);
+        }
+
+        std::ranges::sort(buckets);
+
+        std::vector<std::pair<size_t, size_t>> & pairs = pairs_of_band[band];
+        for (size_t begin = 0, end = 0; begin < buckets.size(); begin = end)
+        {
+            while (end < buckets.size() && buckets[end].first == buckets[begin].first)
+                ++end;
+
+            for (size_t i = begin; i < end; ++i)
+                for (size_t j = i + 1u; j < std::min(end, i + 1u + max_pairs_per_user_bin_and_bucket); ++j)
+                    pairs.emplace_back(buckets[i].second, buckets[j].second);
+        }
+
+        std::ranges::sort(pairs);
+        auto const [first, last] = std::ranges::unique(pairs);
+        pairs.erase(first, last);
+    }
+
+    // Similar user bins collide in many bands. Merging the bands pairwise removes these duplicates in O(log(bands))
+    // rounds of linear merges.
+    for (size_t width = 1u; width < number_of_bands; width *= 2u)
+    {
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+        for (size_t band = 0; band < number_of_bands - width; band += 2u * width)
+            merge_into(pairs_of_band[band], pairs_of_band[band + width]);
+    }
+
+    return std::move(pairs_of_band[0]);
+}
+
+} // namespace chopper::sketch
@@ -5,12 +5,16 @@
 // shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
 // ---------------------------------------------------------------------------------------------------
 
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <ranges>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <vector>
 
 #include <seqan3/utility/range/to.hpp>
@@ -21,15 +25,83 @@
 namespace chopper::sketch
 {
 
-void read_data_file(configuration const & config, std::vector<std::vector<std::string>> & filenames)
+//!\brief 64 bit FNV-1a hash. Unlike std::hash, the result is the same on every platform and for every run.
+static uint64_t fnv1a_hash(std::string_view const str)
+{
+    uint64_t hash{14'695'981'039'346'656'037ULL};
+
+    for (char const chr : str)
+    {
+        hash ^= static_cast<uint8_t>(chr);
+        hash *= 1'099'511'628'211ULL;
+    }
+
+    return hash;
+}
+
+//!\brief The values of the auxiliary fields of a line of the data file.
+struct auxiliary_fields
+{
+    size_t priority{};
+    double fpr{};
+};
+
+/*!\brief Parses the auxiliary fields of a line of the data file, i.e. the tab-separated fields after the filenames.
+ * \details
+ * Fields of the form `priority=<number>` set the priority and fields of the form `fpr=<number>` set the FPR of the
+ * user bin. Other fields are ignored.
+ */
+static auxiliary_fields
+parse_auxiliary_fields(std::string_view const aux_fields, size_t const line_index, configuration const & config)
+{
+    static constexpr std::string_view priority_key{"priority="};
+    static constexpr std::string_view fpr_key{"fpr="};
+    auxiliary_fields result{};
+
+    auto invalid_field = [&](std::string_view const name, std::string_view const value, std::string_view const hint)
+    {
+        return std::runtime_error{"Invalid " + std::string{name} + " \"" + std::string{value} + "\" in line "
+                                  + std::to_string(line_index + 1u) + " of data file " + config.data_file.string()
+                                  + ". The " + std::string{name} + " must be " + std::string{hint} + '.'};
+    };
+
+    for (auto && field : std::views::split(aux_fields, '\t'))
+    {
+        std::string_view const field_sv{std::ranges::data(field), std::ranges::size(field)};
+
+        if (field_sv.starts_with(priority_key))
+        {
+            std::string_view const value{field_sv.substr(priority_key.size())};
+            auto const [ptr, error] = std::from_chars(value.data(), value.data() + value.size(), result.priority);
+
+            if (value.empty() || error != std::errc{} || ptr != value.data() + value.size())
+                throw invalid_field("priority", value, "a non-negative integer");
+        }
+        else if (field_sv.starts_with(fpr_key))
+        {
+            std::string_view const value{field_sv.substr(fpr_key.size())};
+            auto const [ptr, error] = std::from_chars(value.data(), value.data() + value.size(), result.fpr);
+
+            if (value.empty() || error != std::errc{} || ptr != value.data() + value.size() || !(result.fpr > 0.0)
+                || !(result.fpr < 1.0))
+                throw invalid_field("FPR", value, "a number in the open interval (0, 1)");
+        }
+    }
+
+    return result;
+}
+
+data_file_content read_data_file(configuration const & config)
 {
     std::ifstream fin{config.data_file.string()};
 
     if (!fin.good() || !fin.is_open())
         throw std::runtime_error{"Could not open data file " + config.data_file.string() + " for reading."};
 
+    data_file_content result{};
+
     std::string line;
-    while (std::getline(fin, line))
+    for (size_t line_index = 0; std::getline(fin, line); ++line_index)
     {
         std::vector<std::string> names;
 
@@ -37,6 +109,9 @@ void read_data_file(configuration const & config, std::vector<std::vector<std::s
         std::string_view const filename_sv{line.begin(),
                                            (tab_pos != std::string::npos) ? line.begin() + tab_pos : line.end()};
 
+        if (config.shard_by_hash && fnv1a_hash(filename_sv) % config.number_of_shards != config.shard_index)
+            continue;
+
         // multiple filenames may be separated by ' '
         for (auto && name : std::views::split(filename_sv, ' '))
         {
@@ -44,8 +119,38 @@ void read_data_file(configuration const & config, std::vector<std::vector<std::s
             names.emplace_back(common_view.begin(), common_view.end());
         }
 
-        filenames.push_back(std::move(names));
+        result.filenames.push_back(std::move(names));
+        result.user_bin_indices.push_back(line_index);
+
+        auxiliary_fields const aux = tab_pos != std::string::npos
+                                       ? parse_auxiliary_fields(std::string_view{line}.substr(tab_pos + 1),
+                                                                line_index,
+                                                                config)
+                                       : auxiliary_fields{};
+        result.priorities.push_back(aux.priority);
+        result.fprs.push_back(aux.fpr);
+    }
+
+    if (!config.shard_by_hash && config.number_of_shards > 1u)
+    {
+        // Each shard is a contiguous block of lines. Concatenating all shards in order restores the original order.
+        size_t const number_of_lines{result.filenames.size()};
+        size_t const shard_begin{number_of_lines * config.shard_index / config.number_of_shards};
+        size_t const shard_end{number_of_lines * (config.shard_index + 1u) / config.number_of_shards};
+
+        auto keep_shard = [&](auto & values)
+        {
+            values.erase(values.begin() + shard_end, values.end());
+            values.erase(values.begin(), values.begin() + shard_begin);
+        };
+
+        keep_shard(result.filenames);
+        keep_shard(result.user_bin_indices);
+        keep_shard(result.priorities);
+        keep_shard(result.fprs);
     }
+
+    return result;
 }
 
 } // namespace chopper::sketch
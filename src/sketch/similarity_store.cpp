@@ -0,0 +1,216 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <cereal/archives/binary.hpp>
+
+#include <chopper/sketch/hyperloglog_registers.hpp>
+#include <chopper/sketch/lsh_candidates.hpp>
+#include <chopper/sketch/similarity_store.hpp>
+#include <chopper/splitmix64.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+//!\brief Returns a checksum of the registers of all sketches.
+static uint64_t checksum_of(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches)
+{
+    uint64_t checksum{sketches.size()};
+
+    for (seqan::hibf::sketch::hyperloglog const & sketch : sketches)
+    {
+        std::vector<uint8_t> const registers = registers_of(sketch);
+
+        // Eight registers are hashed at once.
+        for (size_t i = 0; i < registers.size(); i += sizeof(uint64_t))
+        {
+            uint64_t word{};
+            std::memcpy(&word, registers.data() + i, std::min(sizeof(uint64_t), registers.size() - i));
+            checksum = splitmix64(checksum ^ word);
+        }
+    }
+
+    return checksum;
+}
+
+//!\brief Returns the number of bits of the sketches.
+static uint8_t bits_of(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches)
+{
+    return sketches.empty() ? 0u : static_cast<uint8_t>(std::countr_zero(sketches[0].data_size()));
+}
+
+//!\brief Returns for each user bin the user bins it forms a pair with.
+static std::vector<std::vector<size_t>> candidates_by_user_bin(size_t const number_of_user_bins,
+                                                               std::vector<std::pair<size_t, size_t>> const & pairs)
+{
+    std::vector<std::vector<size_t>> candidates_of(number_of_user_bins);
+    for (auto const & [i, j] : pairs)
+    {
+        candidates_of[i].push_back(j);
+        candidates_of[j].push_back(i);
+    }
+    return candidates_of;
+}
+
+similarity_store::similarity_store(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                   size_t const neighbours_per_user_bin,
+                                   size_t const threads) :
+    max_neighbours{neighbours_per_user_bin}
+{
+    if (sketches.size() <= max_user_bins_for_all_pairs)
+    {
+        compute_neighbours(sketches, nullptr, threads);
+    }
+    else
+    {
+        std::vector<std::vector<size_t>> const candidates_of =
+            candidates_by_user_bin(sketches.size(), lsh_candidate_pairs(sketches, default_rows_per_band, threads));
+        compute_neighbours(sketches, &candidates_of, threads);
+    }
+}
+
+similarity_store::similarity_store(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                   std::vector<std::pair<size_t, size_t>> const & candidates,
+                                   size_t const neighbours_per_user_bin,
+                                   size_t const threads) :
+    max_neighbours{neighbours_per_user_bin}
+{
+    std::vector<std::vector<size_t>> const candidates_of = candidates_by_user_bin(sketches.size(), candidates);
+    compute_neighbours(sketches, &candidates_of, threads);
+}
+
+bool similarity_store::was_computed_from(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches) const
+{
+    return size() == sketches.size() && sketch_bits == bits_of(sketches) && sketch_checksum == checksum_of(sketches);
+}
+
+void similarity_store::compute_neighbours(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                          std::vector<std::vector<size_t>> const * const candidates_of,
+                                          size_t const threads)
+{
+    size_t const number_of_user_bins{sketches.size()};
+    sketch_bits = bits_of(sketches);
+    sketch_checksum = checksum_of(sketches);
+
+    std::vector<double> estimates(number_of_user_bins);
+    for (size_t i = 0; i < number_of_user_bins; ++i)
+        estimates[i] = sketches[i].estimate();
+
+    auto is_more_similar = [](neighbour const & lhs, neighbour const & rhs)
+    {
+        return lhs.similarity > rhs.similarity || (lhs.similarity == rhs.similarity && lhs.index < rhs.index);
+    };
+
+    std::vector<std::vector<neighbour>> neighbours_of(number_of_user_bins);
+
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+    for (size_t i = 0; i < number_of_user_bins; ++i)
+    {
+        seqan::hibf::sketch::hyperloglog union_sketch{};
+        std::vector<neighbour> & result = neighbours_of[i];
+
+        auto compare_with = [&](size_t const j)
+        {
+            union_sketch = sketches[i];
+            double const union_estimate = union_sketch.merge_and_estimate(sketches[j]);
+            double const intersection = std::max(estimates[i] + estimates[j] - union_estimate, 0.0);
+
+            if (union_estimate <= 0.0 || intersection == 0.0)
+                return;
+
+            // Keep the most similar user bins in a heap whose front is the least similar one.
+            result.push_back({.index = j, .similarity = static_cast<float>(intersection / union_estimate)});
+            std::ranges::push_heap(result, is_more_similar);
+
+            if (result.size() > max_neighbours)
+            {
+                std::ranges::pop_heap(result, is_more_similar);
+                result.pop_back();
+            }
+        };
+
+        if (candidates_of == nullptr)
+        {
+            for (size_t j = 0; j < number_of_user_bins; ++j)
+                if (i != j)
+                    compare_with(j);
+        }
+        else
+        {
+            for (size_t const j : (*candidates_of)[i])
+                compare_with(j);
+        }
+
+        std::ranges::sort(result, is_more_similar);
+    }
+
+    offsets.resize(number_of_user_bins + 1u);
+    for (size_t i = 0; i < number_of_user_bins; ++i)
+    {
+        offsets[i + 1u] = offsets[i] + neighbours_of[i].size();
+        entries.insert(entries.end(), neighbours_of[i].begin(), neighbours_of[i].end());
+        neighbours_of[i] = std::vector<neighbour>{}; // free memory early
+    }
+}
+
+void similarity_store::write_to(std::ostream & stream) const
+{
+    cereal::BinaryOutputArchive archive{stream};
+    archive(*this);
+}
+
+void similarity_store::read_from(std::istream & stream)
+{
+    cereal::BinaryInputArchive archive{stream};
+    archive(*this);
+}
+
+void write_similarity_store_next_to(std::filesystem::path const & sketch_file,
+                                    std::vector<seqan::hibf::sketch::hyperloglog> const & sketches,
+                                    size_t const neighbours_per_user_bin,
+                                    size_t const threads)
+{
+    similarity_store const store{sketches, neighbours_per_user_bin, threads};
+    std::ofstream os{similarity_store_path(sketch_file), std::ios::binary};
+    store.write_to(os);
+}
+
+std::optional<similarity_store>
+read_similarity_store_next_to(std::filesystem::path const & sketch_file,
+                              std::vector<seqan::hibf::sketch::hyperloglog> const & sketches)
+{
+    std::ifstream is{similarity_store_path(sketch_file), std::ios::binary};
+
+    if (!is.good() || !is.is_open())
+        return std::nullopt;
+
+    similarity_store store{};
+    store.read_from(is);
+
+    // E.g., the sketch file was recomputed for a different data file or --sketch-bits, but the store was not.
+    if (!store.was_computed_from(sketches))
+        return std::nullopt;
+
+    return store;
+}
+
+} // namespace chopper::sketch
@@ -0,0 +1,183 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <chopper/sketch/hyperloglog_registers.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+namespace chopper::sketch
+{
+
+sparse_hyperloglog::sparse_hyperloglog(seqan::hibf::sketch::hyperloglog const & sketch) :
+    bits{static_cast<uint8_t>(std::countr_zero(sketch.data_size()))},
+    dense_registers{registers_of(sketch)}
+{
+    choose_representation();
+}
+
+seqan::hibf::sketch::hyperloglog sparse_hyperloglog::to_hyperloglog() const
+{
+    if (!is_sparse())
+        return chopper::sketch::to_hyperloglog(dense_registers);
+
+    std::vector<uint8_t> registers(data_size(), 0u);
+    for (uint64_t const entry : sparse_registers)
+        registers[entry >> 8] = static_cast<uint8_t>(entry & 0xFFu);
+
+    return chopper::sketch::to_hyperloglog(registers);
+}
+
+void sparse_hyperloglog::merge(sparse_hyperloglog const & other)
+{
+    if (bits != other.bits)
+        throw std::invalid_argument{"Cannot merge HyperLogLog sketches with different numbers of registers."};
+
+    if (is_sparse() && other.is_sparse())
+    {
+        std::vector<uint64_t> merged{};
+        merged.reserve(sparse_registers.size() + other.sparse_registers.size());
+
+        auto lhs = sparse_registers.begin();
+        auto rhs = other.sparse_registers.begin();
+
+        while (lhs != sparse_registers.end() && rhs != other.sparse_registers.end())
+        {
+            if ((*lhs >> 8) == (*rhs >> 8)) // Same register: keep the maximum.
+                merged.push_back(std::max(*lhs++, *rhs++));
+            else if (*lhs < *rhs)
+                merged.push_back(*lhs++);
+            else
+                merged.push_back(*rhs++);
+        }
+
+        merged.insert(merged.end(), lhs, sparse_registers.end());
+        merged.insert(merged.end(), rhs, other.sparse_registers.end());
+        sparse_registers = std::move(merged);
+    }
+    else
+    {
+        if (is_sparse())
+        {
+            dense_registers.assign(data_size(), 0u);
+            for (uint64_t const entry : sparse_registers)
+                dense_registers[entry >> 8] = static_cast<uint8_t>(entry & 0xFFu);
+            sparse_registers = std::vector<uint64_t>{};
+        }
+
+        if (other.is_sparse())
+        {
+            for (uint64_t const entry : other.sparse_registers)
+            {
+                uint8_t & reg = dense_registers[entry >> 8];
+                reg = std::max(reg, static_cast<uint8_t>(entry & 0xFFu));
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < dense_registers.size(); ++i)
+                dense_registers[i] = std::max(dense_registers[i], other.dense_registers[i]);
+        }
+    }
+
+    choose_representation();
+}
+
+double sparse_hyperloglog::estimate() const
+{
+    hyperloglog_estimator estimator{data_size()};
+
+    if (is_sparse())
+    {
+        for (uint64_t const entry : sparse_registers)
+            estimator.add(static_cast<uint8_t>(entry & 0xFFu));
+        estimator.add(0u, data_size() - sparse_registers.size());
+    }
+    else
+    {
+        for (uint8_t const value : dense_registers)
+            estimator.add(value);
+    }
+
+    return estimator.estimate();
+}
+
+void sparse_hyperloglog::choose_representation()
+{
+    // A sparse entry uses 8 bytes, a dense register 1 byte.
+    size_t const sparse_limit{data_size() / sizeof(uint64_t)};
+
+    if (is_sparse())
+    {
+        if (sparse_registers.size() < sparse_limit)
+            return;
+
+        dense_registers.assign(data_size(), 0u);
+        for (uint64_t const entry : sparse_registers)
+            dense_registers[entry >> 8] = static_cast<uint8_t>(entry & 0xFFu);
+        sparse_registers = std::vector<uint64_t>{};
+    }
+    else
+    {
+        size_t const non_zero = dense_registers.size() - std::ranges::count(dense_registers, uint8_t{0u});
+
+        if (non_zero >= sparse_limit)
+            return;
+
+        sparse_registers.reserve(non_zero);
+        for (size_t i = 0; i < dense_registers.size(); ++i)
+            if (dense_registers[i] != 0u)
+                sparse_registers.push_back((static_cast<uint64_t>(i) << 8) | dense_registers[i]);
+        dense_registers = std::vector<uint8_t>{};
+    }
+}
+
+std::vector<sparse_hyperloglog> to_sparse_sketches(std::vector<seqan::hibf::sketch::hyperloglog> const & sketches)
+{
+    std::vector<sparse_hyperloglog> result{};
+    result.reserve(sketches.size());
+
+    for (seqan::hibf::sketch::hyperloglog const & sketch : sketches)
+        result.emplace_back(sketch);
+
+    return result;
+}
+
+std::vector<seqan::hibf::sketch::hyperloglog> to_dense_sketches(std::vector<sparse_hyperloglog> const & sketches)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> result{};
+    result.reserve(sketches.size());
+
+    for (sparse_hyperloglog const & sketch : sketches)
+        result.push_back(sketch.to_hyperloglog());
+
+    return result;
+}
+
+std::vector<seqan::hibf::sketch::hyperloglog> to_dense_sketches(std::vector<sparse_hyperloglog> && sketches)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> result{};
+    result.reserve(sketches.size());
+
+    for (sparse_hyperloglog & sketch : sketches)
+    {
+        result.push_back(sketch.to_hyperloglog());
+        sketch = sparse_hyperloglog{};
+    }
+
+    sketches = std::vector<sparse_hyperloglog>{};
+    return result;
+}
+
+} // namespace chopper::sketch
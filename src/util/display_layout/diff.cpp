@@ -0,0 +1,91 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <cereal/archives/binary.hpp>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/input.hpp>
+#include <chopper/layout/layout_diff.hpp>
+#include <chopper/sketch/sketch_file.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
+
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/estimate_kmer_counts.hpp>
+
+#include "shared.hpp"
+
+/*!\brief Reads the k-mer count of each user bin from the sketch file of `chopper_config`.
+ * \details
+ * The sketch file is either the input of the layout or the sketches written next to it. Returns an empty vector if
+ * there is no sketch file, i.e. each user bin counts as one k-mer.
+ */
+static std::vector<size_t> read_kmer_counts(chopper::configuration const & chopper_config)
+{
+    std::filesystem::path sketch_file_path{};
+
+    if (chopper::sketch::has_sketch_file_extension(chopper_config.data_file))
+        sketch_file_path = chopper_config.data_file;
+    else if (!chopper_config.disable_sketch_output)
+        sketch_file_path = chopper_config.sketch_directory;
+
+    if (!chopper::sketch::has_sketch_file_extension(sketch_file_path) || !std::filesystem::exists(sketch_file_path))
+        return {};
+
+    chopper::sketch::sketch_file sin{};
+
+    { // Deserialization is guaranteed to be complete when going out of scope.
+        std::ifstream is{sketch_file_path};
+        cereal::BinaryInputArchive iarchive{is};
+        iarchive(sin);
+    }
+
+    std::vector<size_t> kmer_counts{};
+    seqan::hibf::sketch::estimate_kmer_counts(chopper::sketch::to_dense_sketches(sin.hll_sketches), kmer_counts);
+    return kmer_counts;
+}
+
+void execute_diff(config const & cfg)
+{
+    auto read_layout = [](std::filesystem::path const & path)
+    {
+        std::ifstream layout_file{path};
+        if (!layout_file.good() || !layout_file.is_open())
+            throw std::logic_error{"Could not open file " + path.string() + " for reading"};
+
+        return chopper::layout::read_layout_file(layout_file);
+    };
+
+    auto const previous = read_layout(cfg.previous);
+    auto const current = read_layout(cfg.input);
+
+    std::vector<size_t> kmer_counts = read_kmer_counts(std::get<1>(current));
+    if (kmer_counts.size() != std::get<0>(current).size())
+        kmer_counts.clear();
+
+    chopper::layout::layout_diff const diff = chopper::layout::diff_layouts(std::get<0>(previous),
+                                                                            std::get<2>(previous),
+                                                                            std::get<0>(current),
+                                                                            std::get<2>(current),
+                                                                            kmer_counts);
+
+    std::ofstream output_stream{cfg.output};
+    if (!output_stream.good() || !output_stream.is_open())
+        throw std::logic_error{"Could not open file " + cfg.output.string() + " for writing"};
+
+    if (kmer_counts.empty())
+        output_stream << "# No sketch file found: each user bin counts as one k-mer.\n";
+
+    chopper::layout::write_layout_diff_to(output_stream, diff);
+}
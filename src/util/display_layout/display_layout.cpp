@@ -35,6 +35,16 @@ void general_only_options(sharg::parser & parser, config & cfg)
                                                  "This might be computationally expensive."});
 }
 
+void diff_only_options(sharg::parser & parser, config & cfg)
+{
+    parser.add_option(cfg.previous,
+                      sharg::config{.short_id = '\0',
+                                    .long_id = "previous",
+                                    .description = "The previous layout file to compare the input to.",
+                                    .required = true,
+                                    .validator = sharg::input_file_validator{}});
+}
+
 void init_options(sharg::parser & parser, config & cfg)
 {
     parser.add_subsection("Main options:");
@@ -55,6 +65,9 @@ void init_options(sharg::parser & parser, config & cfg)
     if (parser.info.app_name == std::string_view{"layout_stats-general"})
         general_only_options(parser, cfg);
 
+    if (parser.info.app_name == std::string_view{"layout_stats-diff"})
+        diff_only_options(parser, cfg);
+
     parser.add_option(
         cfg.threads,
         sharg::config{.short_id = '\0', .long_id = "threads", .description = "The number of threads to use."});
@@ -77,7 +90,11 @@ int main(int argc, char const * argv[])
 {
     config cfg{};
 
-    sharg::parser main_parser{"layout_stats", argc, argv, sharg::update_notifications::off, {"general", "sizes"}};
+    sharg::parser main_parser{"layout_stats",
+                              argc,
+                              argv,
+                              sharg::update_notifications::off,
+                              {"general", "sizes", "diff"}};
     init_shared_meta(main_parser);
 
     parse(main_parser);
@@ -91,6 +108,8 @@ int main(int argc, char const * argv[])
         execute_general(cfg);
     else if (sub_parser.info.app_name == std::string_view{"layout_stats-sizes"})
         execute_sizes(cfg);
+    else if (sub_parser.info.app_name == std::string_view{"layout_stats-diff"})
+        execute_diff(cfg);
     else
         std::cerr << "[ERROR] Unknown subcommand\n";
 }
@@ -19,12 +19,14 @@ struct config
 {
     std::filesystem::path input{};
     std::filesystem::path output{};
+    std::filesystem::path previous{};
     bool output_shared_kmers{false};
     uint8_t threads{1u};
 };
 
 void execute_general(config const & cfg);
 void execute_sizes(config const & cfg);
+void execute_diff(config const & cfg);
 
 void process_file(std::string const & filename,
                   std::vector<uint64_t> & current_kmers,
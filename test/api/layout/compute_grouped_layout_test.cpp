@@ -0,0 +1,233 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/compute_grouped_layout.hpp>
+#include <chopper/sketch/similarity_store.hpp>
+
+#include <hibf/layout/compute_layout.hpp>
+#include <hibf/misc/iota_vector.hpp>
+#include <hibf/sketch/compute_sketches.hpp>
+#include <hibf/sketch/estimate_kmer_counts.hpp>
+
+TEST(compute_grouped_layout_test, group_size_within_memory)
+{
+    chopper::configuration config{};
+    config.hibf_config.tmax = 64u;
+
+    using chopper::layout::estimate_dp_memory;
+    using chopper::layout::group_size_within_memory;
+
+    // No limits.
+    EXPECT_EQ(group_size_within_memory(config, config.hibf_config, 100u), 100u);
+
+    // All user bins fit into the memory.
+    config.max_memory_in_bytes = estimate_dp_memory(64u, 100u);
+    EXPECT_EQ(group_size_within_memory(config, config.hibf_config, 100u), 100u);
+
+    // Half of the user bins fit into the memory.
+    config.max_memory_in_bytes = estimate_dp_memory(64u, 50u);
+    EXPECT_EQ(group_size_within_memory(config, config.hibf_config, 100u), 50u);
+
+    // Two groups are computed at once.
+    config.hibf_config.threads = 2u;
+    EXPECT_EQ(group_size_within_memory(config, config.hibf_config, 100u), 25u);
+
+    // --group-size is smaller.
+    config.group_size = 10u;
+    EXPECT_EQ(group_size_within_memory(config, config.hibf_config, 100u), 10u);
+
+    // Not even a single user bin fits.
+    config.max_memory_in_bytes = estimate_dp_memory(64u, 1u);
+    EXPECT_THROW((void)group_size_within_memory(config, config.hibf_config, 100u), std::invalid_argument);
+}
+
+TEST(compute_grouped_layout_test, group_by_size)
+{
+    chopper::configuration config{};
+
+    std::vector<size_t> const kmer_counts{50, 10, 90, 30, 70, 20, 80, 60, 40, 100};
+    auto const groups = chopper::layout::group_user_bins(config, kmer_counts, seqan::hibf::iota_vector(10u), 4u);
+
+    // 10 user bins need 3 groups with at most 4 user bins each. Without similarities, the groups are by size.
+    std::vector<std::vector<size_t>> const expected{{9, 2, 6, 4}, {7, 0, 8}, {3, 5, 1}};
+    EXPECT_EQ(groups, expected);
+}
+
+TEST(compute_grouped_layout_test, divide_into_groups)
+{
+    chopper::configuration config{};
+    config.hibf_config.tmax = 64u;
+
+    std::vector<size_t> const kmer_counts{50, 10, 90, 30, 70, 20, 80, 60, 40, 100};
+    std::vector<size_t> const positions = seqan::hibf::iota_vector(10u);
+
+    // All user bins fit into one group.
+    EXPECT_TRUE(chopper::layout::divide_into_groups(config, config.hibf_config, kmer_counts, positions).empty());
+
+    // --max-memory allows 4 user bins per group.
+    config.max_memory_in_bytes = chopper::layout::estimate_dp_memory(64u, 4u);
+    auto const groups = chopper::layout::divide_into_groups(config, config.hibf_config, kmer_counts, positions);
+    EXPECT_EQ(groups, chopper::layout::group_user_bins(config, kmer_counts, positions, 4u));
+}
+
+TEST(compute_grouped_layout_test, group_by_similarity)
+{
+    // User bin i contains the k-mers of family i % 3, i.e. user bins 0, 3, 6, ... are identical.
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        for (auto hash : std::views::iota(100'000u * (num % 3u), 100'000u * (num % 3u) + 1000u + num))
+            it = hash;
+    };
+
+    chopper::configuration config{};
+    config.hibf_config.input_fn = simulated_input;
+    config.hibf_config.number_of_user_bins = 12u;
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+    std::vector<size_t> kmer_counts;
+    seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
+
+    config.similarities = std::make_shared<chopper::sketch::similarity_store const>(sketches, 3u);
+
+    auto groups = chopper::layout::group_user_bins(config, kmer_counts, seqan::hibf::iota_vector(12u), 4u);
+    ASSERT_EQ(groups.size(), 3u);
+
+    for (auto & group : groups)
+    {
+        ASSERT_EQ(group.size(), 4u);
+        std::ranges::sort(group);
+        EXPECT_TRUE(std::ranges::all_of(group,
+                                        [&](size_t const idx)
+                                        {
+                                            return idx % 3u == group[0] % 3u;
+                                        }));
+    }
+}
+
+TEST(compute_grouped_layout_test, compose)
+{
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        size_t const desired_kmer_count = 101 * ((num + 20) / 20) + num;
+        for (auto hash : std::views::iota(0u, desired_kmer_count))
+            it = hash;
+    };
+
+    chopper::configuration config{};
+    config.hibf_config.input_fn = simulated_input;
+    config.hibf_config.number_of_user_bins = 200u;
+    config.hibf_config.tmax = 64u;
+    config.hibf_config.disable_estimate_union = true; // also disables rearrangement
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+    std::vector<size_t> kmer_counts;
+    seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
+
+    // Without groups, this is the same as compute_layout.
+    auto const monolithic_layout = chopper::layout::compute_grouped_layout(config,
+                                                                           config.hibf_config,
+                                                                           kmer_counts,
+                                                                           sketches,
+                                                                           seqan::hibf::iota_vector(200u));
+    auto const expected_layout = seqan::hibf::layout::compute_layout(config.hibf_config, kmer_counts, sketches);
+    EXPECT_EQ(monolithic_layout.max_bins, expected_layout.max_bins);
+    EXPECT_EQ(monolithic_layout.user_bins, expected_layout.user_bins);
+
+    config.group_size = 50u;
+    config.hibf_config.threads = 4u;
+    auto const grouped_layout = chopper::layout::compute_grouped_layout(config,
+                                                                        config.hibf_config,
+                                                                        kmer_counts,
+                                                                        sketches,
+                                                                        seqan::hibf::iota_vector(200u));
+
+    // Every user bin is in one of the 4 merged bins of the top level.
+    ASSERT_EQ(grouped_layout.user_bins.size(), 200u);
+    std::vector<size_t> user_bins_per_group(4u);
+    std::vector<bool> is_contained(200u, false);
+    for (auto const & user_bin : grouped_layout.user_bins)
+    {
+        ASSERT_FALSE(user_bin.previous_TB_indices.empty());
+        ASSERT_LT(user_bin.previous_TB_indices[0], 4u);
+        ++user_bins_per_group[user_bin.previous_TB_indices[0]];
+        EXPECT_FALSE(is_contained[user_bin.idx]);
+        is_contained[user_bin.idx] = true;
+    }
+    EXPECT_EQ(user_bins_per_group, (std::vector<size_t>{50u, 50u, 50u, 50u}));
+    EXPECT_LT(grouped_layout.top_level_max_bin_id, 4u);
+
+    // Each merged bin of the top level has its maximum bin.
+    for (size_t i = 0; i < 4u; ++i)
+        EXPECT_TRUE(std::ranges::any_of(grouped_layout.max_bins,
+                                        [i](auto const & max_bin)
+                                        {
+                                            return max_bin.previous_TB_indices == std::vector<size_t>{i};
+                                        }));
+
+    // The groups are computed in parallel, but the layout is the same as with a single thread.
+    config.hibf_config.threads = 1u;
+    auto const serial_layout = chopper::layout::compute_grouped_layout(config,
+                                                                       config.hibf_config,
+                                                                       kmer_counts,
+                                                                       sketches,
+                                                                       seqan::hibf::iota_vector(200u));
+    EXPECT_EQ(serial_layout.top_level_max_bin_id, grouped_layout.top_level_max_bin_id);
+    EXPECT_EQ(serial_layout.max_bins, grouped_layout.max_bins);
+    EXPECT_EQ(serial_layout.user_bins, grouped_layout.user_bins);
+
+    // More groups than technical bins.
+    config.group_size = 3u;
+    EXPECT_THROW((void)chopper::layout::compute_grouped_layout(config,
+                                                               config.hibf_config,
+                                                               kmer_counts,
+                                                               sketches,
+                                                               seqan::hibf::iota_vector(200u)),
+                 std::invalid_argument);
+}
+
+TEST(compute_grouped_layout_test, single_user_bin_groups)
+{
+    chopper::configuration config{};
+    config.hibf_config.tmax = 64u;
+    config.hibf_config.disable_estimate_union = true;
+    config.group_size = 1u;
+
+    std::vector<size_t> const kmer_counts{100u, 300u, 200u};
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches(3u);
+
+    auto const layout = chopper::layout::compute_grouped_layout(config,
+                                                                config.hibf_config,
+                                                                kmer_counts,
+                                                                sketches,
+                                                                seqan::hibf::iota_vector(3u));
+
+    // Each group of a single user bin is a split bin of the top level. There are no lower-level IBFs.
+    EXPECT_TRUE(layout.max_bins.empty());
+    ASSERT_EQ(layout.user_bins.size(), 3u);
+    for (size_t i = 0; i < 3u; ++i)
+    {
+        EXPECT_TRUE(layout.user_bins[i].previous_TB_indices.empty());
+        EXPECT_EQ(layout.user_bins[i].storage_TB_id, i);
+        EXPECT_EQ(layout.user_bins[i].number_of_technical_bins, 1u);
+    }
+
+    // The groups are sorted by size, so the largest user bin is in the first technical bin.
+    EXPECT_EQ(layout.user_bins[0].idx, 1u);
+    EXPECT_EQ(layout.top_level_max_bin_id, 0u);
+}
@@ -0,0 +1,131 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/compute_layout_with_pinned_bins.hpp>
+
+#include <hibf/layout/compute_layout.hpp>
+#include <hibf/sketch/compute_sketches.hpp>
+#include <hibf/sketch/estimate_kmer_counts.hpp>
+
+TEST(compute_layout_with_pinned_bins_test, pinned_bins_are_split_on_top_level)
+{
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        // User bin i contains the k-mers [1000 * i, 1000 * i + 500 * (i + 1)).
+        for (auto hash : std::views::iota(1000u * num, 1000u * num + 500u * (num + 1u)))
+            it = hash;
+    };
+
+    chopper::configuration config{};
+    config.hibf_config.input_fn = simulated_input;
+    config.hibf_config.number_of_user_bins = 200u;
+    config.hibf_config.tmax = 64u;
+    config.hibf_config.disable_estimate_union = true; // also disables rearrangement
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+    std::vector<size_t> kmer_counts;
+    seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
+
+    // Without a pinned user bin, the layout is the same as without priorities.
+    auto const unpinned_layout = chopper::layout::compute_layout_with_pinned_bins(config, kmer_counts, sketches, {});
+    auto const expected_layout = seqan::hibf::layout::compute_layout(config.hibf_config, kmer_counts, sketches);
+    EXPECT_EQ(unpinned_layout.top_level_max_bin_id, expected_layout.top_level_max_bin_id);
+    EXPECT_EQ(unpinned_layout.max_bins, expected_layout.max_bins);
+    EXPECT_EQ(unpinned_layout.user_bins, expected_layout.user_bins);
+
+    // The small user bin 3 would be merged on the top level, the large user bin 199 would be split.
+    std::vector<size_t> priorities(config.hibf_config.number_of_user_bins, 0u);
+    priorities[3] = 1u;
+    priorities[199] = 5u;
+
+    auto const hibf_layout =
+        chopper::layout::compute_layout_with_pinned_bins(config, kmer_counts, sketches, priorities);
+
+    ASSERT_EQ(hibf_layout.user_bins.size(), config.hibf_config.number_of_user_bins);
+
+    size_t number_of_top_level_tbs{};
+    for (auto const & user_bin : hibf_layout.user_bins)
+    {
+        if (priorities[user_bin.idx] > 0u)
+            EXPECT_TRUE(user_bin.previous_TB_indices.empty()) << "user bin " << user_bin.idx;
+
+        number_of_top_level_tbs =
+            std::max(number_of_top_level_tbs,
+                     user_bin.previous_TB_indices.empty() ? user_bin.storage_TB_id + user_bin.number_of_technical_bins
+                                                          : user_bin.previous_TB_indices[0] + 1u);
+    }
+
+    EXPECT_LE(number_of_top_level_tbs, config.hibf_config.tmax);
+}
+
+TEST(compute_layout_with_pinned_bins_test, too_many_pinned_bins)
+{
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        for (auto hash : std::views::iota(1000u * num, 1000u * num + 500u))
+            it = hash;
+    };
+
+    chopper::configuration config{};
+    config.hibf_config.input_fn = simulated_input;
+    config.hibf_config.number_of_user_bins = 100u;
+    config.hibf_config.tmax = 64u;
+    config.hibf_config.disable_estimate_union = true; // also disables rearrangement
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+    std::vector<size_t> kmer_counts;
+    seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
+
+    // 64 pinned user bins need all 64 technical bins, but there are 36 other user bins.
+    std::vector<size_t> priorities(config.hibf_config.number_of_user_bins, 0u);
+    std::ranges::fill_n(priorities.begin(), 64, 1u);
+
+    EXPECT_THROW(chopper::layout::compute_layout_with_pinned_bins(config, kmer_counts, sketches, priorities),
+                 std::invalid_argument);
+}
+
+TEST(compute_layout_with_pinned_bins_test, single_level_layout)
+{
+    chopper::configuration config{};
+    config.hibf_config.tmax = 64u;
+
+    std::vector<size_t> const kmer_counts{100u, 3000u, 500u, 1000u};
+    auto const hibf_layout = chopper::layout::compute_single_level_layout(config, kmer_counts);
+
+    ASSERT_EQ(hibf_layout.user_bins.size(), kmer_counts.size());
+    EXPECT_TRUE(hibf_layout.max_bins.empty());
+
+    size_t next_tb{};
+    for (size_t i = 0; i < kmer_counts.size(); ++i)
+    {
+        auto const & user_bin = hibf_layout.user_bins[i];
+        EXPECT_TRUE(user_bin.previous_TB_indices.empty());
+        EXPECT_EQ(user_bin.idx, i);
+        EXPECT_EQ(user_bin.storage_TB_id, next_tb);
+        EXPECT_GE(user_bin.number_of_technical_bins, 1u);
+        next_tb += user_bin.number_of_technical_bins;
+    }
+
+    // All technical bins are used, and larger user bins get more of them.
+    EXPECT_EQ(next_tb, config.hibf_config.tmax);
+    EXPECT_GT(hibf_layout.user_bins[1].number_of_technical_bins, hibf_layout.user_bins[3].number_of_technical_bins);
+    EXPECT_GT(hibf_layout.user_bins[3].number_of_technical_bins, hibf_layout.user_bins[2].number_of_technical_bins);
+
+    config.hibf_config.tmax = 3u;
+    EXPECT_THROW(chopper::layout::compute_single_level_layout(config, kmer_counts), std::invalid_argument);
+}
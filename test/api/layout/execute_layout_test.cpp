@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 
+#include <chopper/layout/determine_best_number_of_technical_bins.hpp>
 #include <chopper/layout/execute.hpp>
 
 #include <hibf/sketch/compute_sketches.hpp>
@@ -429,3 +430,89 @@ TEST(execute_test, many_ubs)
 
     EXPECT_EQ(actual_file, expected_file) << actual_file << std::endl;
 }
+
+TEST(execute_test, many_ubs_max_levels)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const layout_file{tmp_dir.path() / "layout.tsv"};
+
+    std::vector<std::vector<std::string>> many_filenames;
+
+    for (size_t i{0}; i < 96u; ++i)
+        many_filenames.push_back({seqan3::detail::to_string("seq", i)});
+
+    // Same input as in many_ubs, which needs two levels with tmax = 64.
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        size_t const desired_kmer_count = 101 * ((num + 20) / 20) + num;
+        for (auto hash : std::views::iota(0u, desired_kmer_count))
+            it = hash;
+    };
+
+    chopper::configuration config{};
+    config.output_filename = layout_file;
+    config.disable_sketch_output = true;
+    config.max_levels = 1u;
+    config.hibf_config.tmax = 64;
+    config.hibf_config.input_fn = simulated_input;
+    config.hibf_config.number_of_user_bins = many_filenames.size();
+    config.hibf_config.disable_estimate_union = true; // also disables rearrangement
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+
+    chopper::layout::execute(config, many_filenames, sketches);
+
+    // A single level needs at least as many technical bins as user bins.
+    EXPECT_EQ(config.hibf_config.tmax, 128u);
+
+    std::string const actual_file{string_from_file(layout_file)};
+    EXPECT_NE(actual_file.find("#TOP_LEVEL_IBF"), std::string::npos);
+    EXPECT_EQ(actual_file.find("#LOWER_LEVEL_IBF"), std::string::npos) << actual_file;
+}
+
+TEST(execute_test, max_index_size)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const layout_file{tmp_dir.path() / "layout.tsv"};
+
+    std::vector<std::vector<std::string>> many_filenames;
+
+    for (size_t i{0}; i < 96u; ++i)
+        many_filenames.push_back({seqan3::detail::to_string("seq", i)});
+
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        size_t const desired_kmer_count = 101 * ((num + 20) / 20) + num;
+        for (auto hash : std::views::iota(0u, desired_kmer_count))
+            it = hash;
+    };
+
+    chopper::configuration config{};
+    config.output_filename = layout_file;
+    config.disable_sketch_output = true;
+    config.determine_best_tmax = true;
+    config.max_index_size = "1M";
+    config.max_index_size_in_bytes = 1024u * 1024u;
+    config.hibf_config.tmax = 128;
+    config.hibf_config.input_fn = simulated_input;
+    config.hibf_config.number_of_user_bins = many_filenames.size();
+    config.hibf_config.disable_estimate_union = true; // also disables rearrangement
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+
+    // A generous budget fits with the lowest FPR.
+    chopper::layout::execute(config, many_filenames, sketches);
+    EXPECT_EQ(config.hibf_config.maximum_fpr, 0.0001);
+
+    std::string const stats_file{string_from_file(layout_file.string() + ".stats")};
+    EXPECT_NE(stats_file.find("# Lowest false positive rate that fits into 1M: 0.0001"), std::string::npos)
+        << stats_file;
+
+    // Nothing fits into 1 byte.
+    config.max_index_size = "1";
+    config.max_index_size_in_bytes = 1u;
+    EXPECT_THROW(chopper::layout::execute(config, many_filenames, sketches),
+                 chopper::layout::no_layout_within_limits);
+}
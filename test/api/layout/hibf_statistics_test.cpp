@@ -103,6 +103,34 @@ TEST(hibf_statistics, only_merged_on_top_level)
     EXPECT_EQ(summary, expected_cout);
 }
 
+TEST(hibf_statistics, query_weights)
+{
+    chopper::configuration config{}; // default config
+    config.hibf_config.tmax = 64u;
+    config.hibf_config.disable_estimate_union = true; /* also disable rearrangement */
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches{{}, {}};
+    std::vector<size_t> kmer_counts{50, 50};
+
+    // User bin 0 is split on the top level (1 IBF to query).
+    // User bin 1 is in the merged bin 2 on the top level (2 IBFs to query).
+    auto expected_query_cost = [&](std::vector<double> const & query_weights)
+    {
+        chopper::layout::hibf_statistics stats(config, sketches, kmer_counts);
+        stats.hibf_layout.max_bins.emplace_back(std::vector<size_t>{2u}, 0u);
+        stats.hibf_layout.user_bins.emplace_back(std::vector<size_t>{}, 0u, 2u, 0u);
+        stats.hibf_layout.user_bins.emplace_back(std::vector<size_t>{2u}, 0u, 1u, 1u);
+        stats.query_weights = query_weights;
+        stats.finalize();
+        return stats.expected_HIBF_query_cost;
+    };
+
+    EXPECT_DOUBLE_EQ(expected_query_cost({}), 1.5);          // weighted by k-mer counts
+    EXPECT_DOUBLE_EQ(expected_query_cost({1.0, 1.0}), 1.5);  // uniform queries
+    EXPECT_DOUBLE_EQ(expected_query_cost({1.0, 0.0}), 1.0);  // only the split user bin is queried
+    EXPECT_DOUBLE_EQ(expected_query_cost({1.0, 3.0}), 1.75); // mostly the merged user bin is queried
+}
+
 TEST(execute_test, chopper_layout_statistics)
 {
     seqan3::test::tmp_directory tmp_dir{};
@@ -223,3 +251,45 @@ TEST(execute_test, chopper_layout_statistics_determine_best_bins)
 
     EXPECT_EQ(written_file, expected_cout) << written_file;
 }
+
+TEST(execute_test, chopper_layout_statistics_determine_best_bins_query_cost_weight)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const binning_filename{tmp_dir.path() / "output.binning"};
+    std::filesystem::path const stats_file{binning_filename.string() + ".stats"};
+
+    std::vector<std::vector<std::string>>
+        filenames{{"seq0"}, {"seq1"}, {"seq2"}, {"seq3"}, {"seq4"}, {"seq5"}, {"seq6"}, {"seq7"}, {"seq8"}, {"seq9"}};
+
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        std::vector<size_t> kmer_counts{10000, 20000, 30000, 40000, 50000, 60000, 70000, 80000, 90000, 100000};
+        for (auto hash : std::views::iota(0u, kmer_counts[num]))
+            it = hash;
+    };
+
+    chopper::configuration config{.data_file = "not needed",
+                                  .output_filename = binning_filename.c_str(),
+                                  .disable_sketch_output = true,
+                                  .determine_best_tmax = true,
+                                  .force_all_binnings = true,
+                                  .hibf_config = {.input_fn = simulated_input,
+                                                  .number_of_user_bins = filenames.size(),
+                                                  .tmax = 128,
+                                                  .disable_estimate_union = true /* also disable rearrangement */}};
+    config.query_cost_weight = 0.0; // Only memory matters: tmax 64 needs 3.1MiB, tmax 128 needs 4.3MiB.
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+
+    chopper::layout::execute(config, filenames, sketches);
+
+    ASSERT_TRUE(std::filesystem::exists(stats_file));
+
+    std::string const written_file{string_from_file(stats_file)};
+
+    EXPECT_TRUE(written_file.ends_with(
+        "# Best t_max (regarding expected query runtime with weight 0.00 and memory with weight 1.00): 64\n"))
+        << written_file;
+    EXPECT_EQ(config.hibf_config.tmax, 64u);
+}
@@ -7,8 +7,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <bit>
+#include <cmath>
 #include <cstddef>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 
@@ -16,41 +19,126 @@
 
 TEST(ibf_query_cost_test, exact)
 {
+    chopper::layout::ibf_query_cost const cost{};
+
     double value{};
     for (size_t i{64}; i <= chopper::layout::ibf_query_cost::maximum_t_max; i *= 2)
     {
-        double result = chopper::layout::ibf_query_cost::exact(i, 0.0125);
+        double result = cost.exact(i, 0.0125);
         EXPECT_GT(result, value);
         value = result;
     }
 
-    EXPECT_NO_THROW(chopper::layout::ibf_query_cost::exact(chopper::layout::ibf_query_cost::maximum_t_max, 0.0125));
-    ASSERT_EQ(chopper::layout::ibf_query_cost::exact(chopper::layout::ibf_query_cost::maximum_t_max, 0.0125), 54.4134);
-    EXPECT_THROW(chopper::layout::ibf_query_cost::exact(chopper::layout::ibf_query_cost::maximum_t_max + 1, 0.0125),
-                 std::invalid_argument);
+    EXPECT_NO_THROW(cost.exact(chopper::layout::ibf_query_cost::maximum_t_max, 0.0125));
+    ASSERT_EQ(cost.exact(chopper::layout::ibf_query_cost::maximum_t_max, 0.0125), 54.4134);
+    EXPECT_THROW(cost.exact(chopper::layout::ibf_query_cost::maximum_t_max + 1, 0.0125), std::invalid_argument);
 }
 
 TEST(ibf_query_cost_test, interpolated)
 {
+    chopper::layout::ibf_query_cost const cost{};
+
     for (size_t i{64}; i <= chopper::layout::ibf_query_cost::maximum_t_max; i *= 2)
-        EXPECT_EQ(chopper::layout::ibf_query_cost::interpolated(i, 0.0125),
-                  chopper::layout::ibf_query_cost::exact(i, 0.0125));
+        EXPECT_EQ(cost.interpolated(i, 0.0125), cost.exact(i, 0.0125));
 
     double value{};
     for (size_t i{67}; i < chopper::layout::ibf_query_cost::maximum_t_max; i *= 2)
     {
-        double result = chopper::layout::ibf_query_cost::interpolated(i, 0.0125);
+        double result = cost.interpolated(i, 0.0125);
         EXPECT_GT(result, value);
-        EXPECT_GT(result,
-                  chopper::layout::ibf_query_cost::exact(1ULL << (std::bit_width(i) - 1),
-                                                         0.0125)); // std::bit_floor not in seqan3
-        EXPECT_LT(result, chopper::layout::ibf_query_cost::exact(std::bit_ceil(i), 0.0125));
+        EXPECT_GT(result, cost.exact(1ULL << (std::bit_width(i) - 1), 0.0125)); // std::bit_floor not in seqan3
+        EXPECT_LT(result, cost.exact(std::bit_ceil(i), 0.0125));
         value = result;
     }
 
-    EXPECT_NO_THROW(
-        chopper::layout::ibf_query_cost::interpolated(chopper::layout::ibf_query_cost::maximum_t_max, 0.0125));
-    EXPECT_THROW(
-        chopper::layout::ibf_query_cost::interpolated(chopper::layout::ibf_query_cost::maximum_t_max + 1, 0.0125),
-        std::invalid_argument);
+    EXPECT_NO_THROW(cost.interpolated(chopper::layout::ibf_query_cost::maximum_t_max, 0.0125));
+}
+
+TEST(ibf_query_cost_test, extrapolated_t_max)
+{
+    using chopper::layout::ibf_query_cost;
+    ibf_query_cost const cost{};
+
+    // Beyond maximum_t_max, the cost continues to grow with the rate of the last doubling.
+    double const last_value{cost.exact(ibf_query_cost::maximum_t_max, 0.0125)};
+    double const growth{last_value / cost.exact(ibf_query_cost::maximum_t_max / 2, 0.0125)};
+
+    EXPECT_GT(cost.interpolated(ibf_query_cost::maximum_t_max + 1, 0.0125), last_value);
+    EXPECT_DOUBLE_EQ(cost.interpolated(2 * ibf_query_cost::maximum_t_max, 0.0125), last_value * growth);
+    EXPECT_DOUBLE_EQ(cost.interpolated(4 * ibf_query_cost::maximum_t_max, 0.0125),
+                     last_value * growth * growth);
+}
+
+TEST(ibf_query_cost_test, interpolated_fpr)
+{
+    using chopper::layout::ibf_query_cost;
+    ibf_query_cost const cost{};
+
+    // Between two measured FPRs, the cost lies between the cost of both rows.
+    for (size_t t_max{64}; t_max <= ibf_query_cost::maximum_t_max; t_max *= 2)
+    {
+        double const lower_value{cost.exact(t_max, 0.0025)};
+        double const upper_value{cost.exact(t_max, 0.0125)};
+        double const result{cost.interpolated(t_max, 0.005)};
+
+        EXPECT_GE(result, std::min(lower_value, upper_value));
+        EXPECT_LE(result, std::max(lower_value, upper_value));
+    }
+
+    // The cost changes continuously with the FPR.
+    EXPECT_NEAR(cost.interpolated(4096, 0.0125 - 1e-9), cost.exact(4096, 0.0125), 1e-5);
+    EXPECT_NEAR(cost.interpolated(4096, 0.0125 + 1e-9), cost.exact(4096, 0.0125), 1e-5);
+
+    // The midpoint in log-space is the arithmetic mean of both rows.
+    EXPECT_DOUBLE_EQ(cost.interpolated(4096, std::sqrt(0.0025 * 0.0125)),
+                     (cost.exact(4096, 0.0025) + cost.exact(4096, 0.0125)) / 2);
+
+    // FPRs outside of the table use the closest row.
+    EXPECT_EQ(cost.interpolated(4096, 0.00001), cost.exact(4096, 0.0001));
+    EXPECT_EQ(cost.interpolated(4096, 0.5), cost.exact(4096, 0.3125));
+}
+
+TEST(ibf_query_cost_test, read_and_write_table)
+{
+    using chopper::layout::ibf_query_cost;
+
+    ibf_query_cost::table_type const table{
+        {0.05, {1.0, 1.5, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0}},
+        {0.3, {1.0, 2.5, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0}}};
+
+    std::stringstream stream{};
+    ibf_query_cost::write_to(stream, table);
+
+    EXPECT_EQ(stream.str(),
+              "# FPR\t64\t128\t256\t512\t1024\t2048\t4096\t8192\t16384\t32768\t65536\n"
+              "0.05\t1.0000\t1.5000\t2.0000\t3.0000\t4.0000\t5.0000\t6.0000\t7.0000\t8.0000\t9.0000\t10.0000\n"
+              "0.3\t1.0000\t2.5000\t3.0000\t4.0000\t5.0000\t6.0000\t7.0000\t8.0000\t9.0000\t10.0000\t11.0000\n");
+
+    ibf_query_cost const cost = ibf_query_cost::read_from(stream);
+    EXPECT_EQ(cost.table(), table);
+    EXPECT_EQ(cost.exact(128, 0.05), 1.5);
+    EXPECT_EQ(cost.exact(128, 0.25), 2.5); // closest FPR is 0.3
+
+    // The built-in table is not affected.
+    EXPECT_EQ(ibf_query_cost{}.exact(ibf_query_cost::maximum_t_max, 0.0125), 54.4134);
+}
+
+TEST(ibf_query_cost_test, read_malformed_table)
+{
+    using chopper::layout::ibf_query_cost;
+
+    auto read = [](std::string const & content)
+    {
+        std::stringstream stream{content};
+        (void)ibf_query_cost::read_from(stream);
+    };
+
+    EXPECT_THROW(read("# only a comment\n"), std::invalid_argument);
+    EXPECT_THROW(read("0.05\t1\t2\n"), std::invalid_argument);
+    EXPECT_THROW(read("1.5\t1\t2\t3\t4\t5\t6\t7\t8\t9\t10\t11\n"), std::invalid_argument);
+    EXPECT_THROW(read("0.05\t1\t2\t3\t4\t5\t6\t7\t8\t9\t10\t11\t12\n"), std::invalid_argument);
+    EXPECT_THROW(read("0.05\t1\t2\t3\t4\t5\t6\t7\t8\t9\t10\t11\n"
+                      "0.05\t1\t2\t3\t4\t5\t6\t7\t8\t9\t10\t11\n"),
+                 std::invalid_argument);
+    EXPECT_THROW(read("0.05\t1\t2\t3\t4\t5\t6\t5\t8\t9\t10\t11\n"), std::invalid_argument); // decreases
 }
@@ -0,0 +1,101 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <chopper/layout/layout_diff.hpp>
+
+#include <hibf/layout/layout.hpp>
+
+TEST(layout_diff_test, added_and_removed_user_bins)
+{
+    std::vector<std::vector<std::string>> const previous_filenames{{"a"}, {"b"}, {"c"}, {"d"}};
+    seqan::hibf::layout::layout previous_layout{};
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{0u}, 0u, 1u, 0u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{0u}, 1u, 1u, 1u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{}, 1u, 1u, 2u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{}, 2u, 2u, 3u);
+
+    // "d" was replaced by "e" and the user bins are in a different order.
+    std::vector<std::vector<std::string>> const filenames{{"b"}, {"a"}, {"c"}, {"e"}};
+    seqan::hibf::layout::layout hibf_layout{};
+    hibf_layout.user_bins.emplace_back(std::vector<size_t>{0u}, 1u, 1u, 0u);
+    hibf_layout.user_bins.emplace_back(std::vector<size_t>{0u}, 0u, 1u, 1u);
+    hibf_layout.user_bins.emplace_back(std::vector<size_t>{}, 1u, 1u, 2u);
+    hibf_layout.user_bins.emplace_back(std::vector<size_t>{}, 2u, 1u, 3u);
+
+    std::vector<size_t> const kmer_counts{10u, 20u, 30u, 40u};
+
+    chopper::layout::layout_diff const diff =
+        chopper::layout::diff_layouts(previous_filenames, previous_layout, filenames, hibf_layout, kmer_counts);
+
+    EXPECT_EQ(diff.number_of_ibfs, 2u);
+    EXPECT_EQ(diff.moved_user_bins, 0u);
+    EXPECT_EQ(diff.added_user_bins, 1u);
+    EXPECT_EQ(diff.removed_user_bins, 1u);
+
+    // Only the top-level IBF changed. The lower-level IBF of the merged bin 0 can be reused.
+    ASSERT_EQ(diff.changed_ibfs.size(), 1u);
+    EXPECT_TRUE(diff.changed_ibfs[0].previous_TB_indices.empty());
+    EXPECT_EQ(diff.changed_ibfs[0].user_bins, 4u);
+    EXPECT_EQ(diff.changed_ibfs[0].kmers, 100u);
+    EXPECT_EQ(diff.rebuilt_kmers, 100u);
+    EXPECT_EQ(diff.total_kmers, 130u);
+
+    std::stringstream output{};
+    chopper::layout::write_layout_diff_to(output, diff);
+    EXPECT_EQ(output.str(),
+              "# IBFs to rebuild: 1 of 2\n"
+              "# User bins: 0 moved, 1 added, 1 removed\n"
+              "# K-mers to insert: 100 of 130 (76.92%)\n"
+              "IBF\tUSER_BINS\tKMERS\n"
+              "HIGH_LEVEL_IBF\t4\t100\n");
+}
+
+TEST(layout_diff_test, moved_user_bins)
+{
+    std::vector<std::vector<std::string>> const filenames{{"a"}, {"b", "c"}, {"d"}};
+    seqan::hibf::layout::layout previous_layout{};
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{0u}, 0u, 1u, 0u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{0u}, 1u, 1u, 1u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{}, 1u, 1u, 2u);
+
+    // Without k-mer counts, each user bin counts as one k-mer.
+    chopper::layout::layout_diff diff =
+        chopper::layout::diff_layouts(filenames, previous_layout, filenames, previous_layout, {});
+    EXPECT_TRUE(diff.changed_ibfs.empty());
+    EXPECT_EQ(diff.total_kmers, 5u);
+    EXPECT_EQ(diff.rebuilt_fraction(), 0.0);
+
+    // Swapping the technical bins of "a" and "b c" changes the lower-level IBF, but not the top-level IBF.
+    seqan::hibf::layout::layout hibf_layout{previous_layout};
+    hibf_layout.user_bins[0].storage_TB_id = 1u;
+    hibf_layout.user_bins[1].storage_TB_id = 0u;
+
+    diff = chopper::layout::diff_layouts(filenames, previous_layout, filenames, hibf_layout, {});
+    EXPECT_EQ(diff.moved_user_bins, 2u);
+    ASSERT_EQ(diff.changed_ibfs.size(), 1u);
+    EXPECT_EQ(diff.changed_ibfs[0].previous_TB_indices, (std::vector<size_t>{0u}));
+    EXPECT_EQ(diff.rebuilt_kmers, 2u);
+
+    // An unchanged IBF can be reused at a different position.
+    for (auto & user_bin : hibf_layout.user_bins)
+        if (!user_bin.previous_TB_indices.empty())
+            user_bin.previous_TB_indices[0] = 2u;
+
+    hibf_layout.user_bins[0].storage_TB_id = 0u;
+    hibf_layout.user_bins[1].storage_TB_id = 1u;
+
+    diff = chopper::layout::diff_layouts(filenames, previous_layout, filenames, hibf_layout, {});
+    ASSERT_EQ(diff.changed_ibfs.size(), 1u);
+    EXPECT_TRUE(diff.changed_ibfs[0].previous_TB_indices.empty());
+}
@@ -0,0 +1,160 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/partition_user_bins.hpp>
+#include <chopper/sketch/similarity_store.hpp>
+
+#include <hibf/sketch/compute_sketches.hpp>
+#include <hibf/sketch/estimate_kmer_counts.hpp>
+
+#include "../api_test.hpp"
+
+TEST(partition_user_bins_test, partition_layout_path)
+{
+    EXPECT_EQ(chopper::layout::partition_layout_path("layout.txt", 0u), std::filesystem::path{"layout.0.txt"});
+    EXPECT_EQ(chopper::layout::partition_layout_path("/tmp/out/chopper.layout", 12u),
+              std::filesystem::path{"/tmp/out/chopper.12.layout"});
+    EXPECT_EQ(chopper::layout::partition_layout_path("layout", 1u), std::filesystem::path{"layout.1"});
+}
+
+TEST(partition_user_bins_test, partition_configuration)
+{
+    chopper::configuration config{};
+    config.output_filename = "layout.txt";
+    config.number_of_partitions = 4u;
+    config.hibf_config.number_of_user_bins = 100u;
+    config.similarities = std::make_shared<chopper::sketch::similarity_store const>();
+    config.user_bin_fprs.assign(100u, 0.0);
+    config.user_bin_fprs[7] = 0.001;
+
+    chopper::configuration const partition_config =
+        chopper::layout::partition_configuration(config, 2u, std::vector<size_t>{5u, 7u, 9u});
+
+    EXPECT_EQ(partition_config.output_filename, std::filesystem::path{"layout.2.txt"});
+    EXPECT_EQ(partition_config.number_of_partitions, 1u);
+    EXPECT_EQ(partition_config.hibf_config.number_of_user_bins, 3u);
+    EXPECT_EQ(partition_config.similarities, nullptr);
+    EXPECT_RANGE_EQ(partition_config.user_bin_fprs, (std::vector<double>{0.0, 0.001, 0.0}));
+    EXPECT_EQ(partition_config.hibf_config.maximum_fpr, 0.001);
+
+    // Only the partition with the strict user bin uses its FPR.
+    EXPECT_EQ(chopper::layout::partition_configuration(config, 1u, std::vector<size_t>{5u, 9u}).hibf_config.maximum_fpr,
+              config.hibf_config.maximum_fpr);
+}
+
+TEST(partition_user_bins_test, similar_and_balanced)
+{
+    // User bin i contains the k-mers of family i % 3, i.e. user bins 0, 3, 6, ... are almost identical.
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        for (auto hash : std::views::iota(100'000u * (num % 3u), 100'000u * (num % 3u) + 2000u + num))
+            it = hash;
+    };
+
+    chopper::configuration config{};
+    config.hibf_config.input_fn = simulated_input;
+    config.hibf_config.number_of_user_bins = 30u;
+    config.hibf_config.tmax = 64u;
+    config.number_of_partitions = 3u;
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+    std::vector<size_t> kmer_counts;
+    seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
+
+    config.similarities = std::make_shared<chopper::sketch::similarity_store const>(sketches, 4u);
+
+    auto const partitions = chopper::layout::partition_user_bins(config, kmer_counts, sketches, {});
+    ASSERT_EQ(partitions.size(), 3u);
+
+    std::vector<size_t> all_user_bins{};
+    for (auto const & partition : partitions)
+    {
+        // Each partition holds one family.
+        ASSERT_EQ(partition.size(), 10u);
+        EXPECT_TRUE(std::ranges::is_sorted(partition));
+        EXPECT_TRUE(std::ranges::all_of(partition,
+                                        [&](size_t const idx)
+                                        {
+                                            return idx % 3u == partition[0] % 3u;
+                                        }));
+        all_user_bins.insert(all_user_bins.end(), partition.begin(), partition.end());
+    }
+
+    // Every user bin is in exactly one partition.
+    std::ranges::sort(all_user_bins);
+    EXPECT_TRUE(std::ranges::equal(all_user_bins, std::views::iota(0u, 30u)));
+}
+
+TEST(partition_user_bins_test, different_fprs)
+{
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        for (auto hash : std::views::iota(10'000u * num, 10'000u * num + 2000u))
+            it = hash;
+    };
+
+    chopper::configuration config{};
+    config.hibf_config.input_fn = simulated_input;
+    config.hibf_config.number_of_user_bins = 30u;
+    config.hibf_config.tmax = 64u;
+    config.hibf_config.maximum_fpr = 0.05;
+    config.user_bin_fprs.assign(30u, 0.0);
+    std::fill_n(config.user_bin_fprs.begin() + 20, 10u, 0.001);
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+    std::vector<size_t> kmer_counts;
+    seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
+
+    // Without --partitions, each FPR gets one partition. The strictest FPR comes first.
+    auto partitions = chopper::layout::partition_user_bins(config, kmer_counts, sketches, {});
+    ASSERT_EQ(partitions.size(), 2u);
+    EXPECT_TRUE(std::ranges::equal(partitions[0], std::views::iota(20u, 30u)));
+    EXPECT_TRUE(std::ranges::equal(partitions[1], std::views::iota(0u, 20u)));
+    EXPECT_EQ(chopper::layout::partition_configuration(config, 0u, partitions[0]).hibf_config.maximum_fpr, 0.001);
+    EXPECT_EQ(chopper::layout::partition_configuration(config, 1u, partitions[1]).hibf_config.maximum_fpr, 0.05);
+
+    // The additional partition goes to the FPR with the most k-mers.
+    config.number_of_partitions = 3u;
+    partitions = chopper::layout::partition_user_bins(config, kmer_counts, sketches, {});
+    ASSERT_EQ(partitions.size(), 3u);
+    EXPECT_TRUE(std::ranges::equal(partitions[0], std::views::iota(20u, 30u)));
+
+    for (size_t const partition : {1u, 2u})
+    {
+        EXPECT_FALSE(partitions[partition].empty());
+        EXPECT_TRUE(std::ranges::all_of(partitions[partition],
+                                        [](size_t const idx)
+                                        {
+                                            return idx < 20u;
+                                        }));
+    }
+    EXPECT_EQ(partitions[1].size() + partitions[2].size(), 20u);
+}
+
+TEST(partition_user_bins_test, too_many_partitions)
+{
+    chopper::configuration config{};
+    config.number_of_partitions = 5u;
+
+    std::vector<size_t> const kmer_counts{10u, 20u, 30u};
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches(3u);
+
+    EXPECT_THROW((void)chopper::layout::partition_user_bins(config, kmer_counts, sketches, {}), std::invalid_argument);
+}
@@ -0,0 +1,177 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/refine_layout.hpp>
+#include <chopper/splitmix64.hpp>
+
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+// User bin i contains the values [100'000 * i, 100'000 * i + sizes[i]).
+std::vector<seqan::hibf::sketch::hyperloglog> disjoint_sketches(std::vector<size_t> const & sizes)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches{};
+
+    for (uint64_t i = 0; i < sizes.size(); ++i)
+    {
+        seqan::hibf::sketch::hyperloglog sketch{12u};
+        for (uint64_t value : std::views::iota(100'000u * i, 100'000u * i + sizes[i]))
+            sketch.add(chopper::splitmix64(value));
+        sketches.push_back(std::move(sketch));
+    }
+
+    return sketches;
+}
+
+chopper::configuration refinement_config()
+{
+    chopper::configuration config{};
+    config.hibf_config.tmax = 64u;
+    config.hibf_config.sketch_bits = 12u;
+    config.refinement_time = 10.0;
+    return config;
+}
+
+TEST(refine_layout_test, move_user_bin_between_merged_bins)
+{
+    chopper::configuration const config = refinement_config();
+    std::vector<size_t> const kmer_counts{1000u, 1000u, 1000u, 1000u, 100u};
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = disjoint_sketches(kmer_counts);
+
+    // Merged bin 0 holds three user bins, merged bin 1 only one. User bin 4 is split into the technical bins 2 and 3.
+    seqan::hibf::layout::layout hibf_layout{
+        .top_level_max_bin_id = 0u,
+        .max_bins = {{.previous_TB_indices = {0u}, .id = 0u}, {.previous_TB_indices = {1u}, .id = 0u}},
+        .user_bins = {{.previous_TB_indices = {0u}, .storage_TB_id = 0u, .number_of_technical_bins = 1u, .idx = 0u},
+                      {.previous_TB_indices = {0u}, .storage_TB_id = 1u, .number_of_technical_bins = 1u, .idx = 1u},
+                      {.previous_TB_indices = {0u}, .storage_TB_id = 2u, .number_of_technical_bins = 1u, .idx = 2u},
+                      {.previous_TB_indices = {1u}, .storage_TB_id = 0u, .number_of_technical_bins = 1u, .idx = 3u},
+                      {.previous_TB_indices = {}, .storage_TB_id = 2u, .number_of_technical_bins = 2u, .idx = 4u}}};
+
+    chopper::layout::refinement_result const result =
+        chopper::layout::refine_layout(config, hibf_layout, kmer_counts, sketches, {});
+
+    // One user bin moves from merged bin 0 to merged bin 1. Afterwards, both hold two user bins.
+    EXPECT_EQ(result.moves, 1u);
+    EXPECT_LT(result.max_bin_size_after, result.max_bin_size_before);
+
+    std::vector<size_t> user_bins_in(2u, 0u);
+    std::vector<std::vector<size_t>> child_tbs(2u);
+    for (auto const & user_bin : hibf_layout.user_bins)
+    {
+        if (user_bin.idx == 4u)
+        {
+            EXPECT_TRUE(user_bin.previous_TB_indices.empty());
+            continue;
+        }
+
+        ASSERT_EQ(user_bin.previous_TB_indices.size(), 1u);
+        ASSERT_LT(user_bin.previous_TB_indices[0], 2u);
+        ++user_bins_in[user_bin.previous_TB_indices[0]];
+        child_tbs[user_bin.previous_TB_indices[0]].push_back(user_bin.storage_TB_id);
+    }
+
+    EXPECT_EQ(user_bins_in, (std::vector<size_t>{2u, 2u}));
+
+    // The technical bins of the lower-level IBFs are consecutive.
+    for (auto & tbs : child_tbs)
+    {
+        std::ranges::sort(tbs);
+        EXPECT_EQ(tbs, (std::vector<size_t>{0u, 1u}));
+    }
+
+    EXPECT_LT(hibf_layout.top_level_max_bin_id, 2u);
+    ASSERT_EQ(hibf_layout.max_bins.size(), 2u);
+    for (auto const & max_bin : hibf_layout.max_bins)
+        EXPECT_LT(max_bin.id, 2u);
+}
+
+TEST(refine_layout_test, add_technical_bin_to_split_bin)
+{
+    chopper::configuration const config = refinement_config();
+    std::vector<size_t> const kmer_counts{8000u, 1000u};
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = disjoint_sketches(kmer_counts);
+
+    // User bin 0 is the largest technical bin, user bin 1 is split into 4 small technical bins.
+    seqan::hibf::layout::layout hibf_layout{
+        .top_level_max_bin_id = 0u,
+        .max_bins = {},
+        .user_bins = {{.previous_TB_indices = {}, .storage_TB_id = 0u, .number_of_technical_bins = 1u, .idx = 0u},
+                      {.previous_TB_indices = {}, .storage_TB_id = 1u, .number_of_technical_bins = 4u, .idx = 1u}}};
+
+    chopper::layout::refinement_result const result =
+        chopper::layout::refine_layout(config, hibf_layout, kmer_counts, sketches, {});
+
+    EXPECT_GT(result.moves, 0u);
+    EXPECT_LT(result.max_bin_size_after, result.max_bin_size_before);
+
+    // The technical bins are consecutive and user bin 0 is split now.
+    auto const & first = hibf_layout.user_bins[0];
+    auto const & second = hibf_layout.user_bins[1];
+    EXPECT_EQ(first.storage_TB_id, 0u);
+    EXPECT_GT(first.number_of_technical_bins, 1u);
+    EXPECT_EQ(second.storage_TB_id, first.number_of_technical_bins);
+    EXPECT_GE(second.number_of_technical_bins, 1u);
+    EXPECT_LE(second.storage_TB_id + second.number_of_technical_bins, config.hibf_config.tmax);
+    EXPECT_TRUE(hibf_layout.top_level_max_bin_id == first.storage_TB_id
+                || hibf_layout.top_level_max_bin_id == second.storage_TB_id);
+}
+
+TEST(refine_layout_test, pinned_user_bins_keep_their_technical_bins)
+{
+    chopper::configuration config = refinement_config();
+    config.hibf_config.tmax = 5u;
+
+    std::vector<size_t> const kmer_counts{8000u, 1000u};
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = disjoint_sketches(kmer_counts);
+
+    // All technical bins are used. User bin 0 could only grow by taking a technical bin of user bin 1.
+    seqan::hibf::layout::layout const initial_layout{
+        .top_level_max_bin_id = 0u,
+        .max_bins = {},
+        .user_bins = {{.previous_TB_indices = {}, .storage_TB_id = 0u, .number_of_technical_bins = 1u, .idx = 0u},
+                      {.previous_TB_indices = {}, .storage_TB_id = 1u, .number_of_technical_bins = 4u, .idx = 1u}}};
+
+    seqan::hibf::layout::layout hibf_layout{initial_layout};
+    EXPECT_GT(chopper::layout::refine_layout(config, hibf_layout, kmer_counts, sketches, {}).moves, 0u);
+
+    // User bin 1 is pinned.
+    hibf_layout = initial_layout;
+    EXPECT_EQ(chopper::layout::refine_layout(config, hibf_layout, kmer_counts, sketches, {0u, 1u}).moves, 0u);
+    EXPECT_EQ(hibf_layout.user_bins, initial_layout.user_bins);
+}
+
+TEST(refine_layout_test, no_time)
+{
+    chopper::configuration config = refinement_config();
+    config.refinement_time = 0.0;
+
+    std::vector<size_t> const kmer_counts{8000u, 1000u};
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = disjoint_sketches(kmer_counts);
+
+    seqan::hibf::layout::layout hibf_layout{
+        .top_level_max_bin_id = 0u,
+        .max_bins = {},
+        .user_bins = {{.previous_TB_indices = {}, .storage_TB_id = 0u, .number_of_technical_bins = 1u, .idx = 0u},
+                      {.previous_TB_indices = {}, .storage_TB_id = 1u, .number_of_technical_bins = 4u, .idx = 1u}}};
+    seqan::hibf::layout::layout const expected{hibf_layout};
+
+    chopper::layout::refinement_result const result =
+        chopper::layout::refine_layout(config, hibf_layout, kmer_counts, sketches, {});
+
+    EXPECT_EQ(result.moves, 0u);
+    EXPECT_EQ(hibf_layout.user_bins, expected.user_bins);
+}
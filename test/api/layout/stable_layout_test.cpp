@@ -0,0 +1,178 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/stable_layout.hpp>
+
+#include <hibf/layout/layout.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+using max_bin_t = seqan::hibf::layout::layout::max_bin;
+using user_bin_t = seqan::hibf::layout::layout::user_bin;
+
+TEST(stable_layout_test, update_max_bins)
+{
+    chopper::configuration config{};
+    config.hibf_config.tmax = 64u;
+    config.hibf_config.disable_estimate_union = true;
+
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches(4u);
+    std::vector<size_t> const kmer_counts{100u, 200u, 500u, 600u};
+
+    seqan::hibf::layout::layout hibf_layout{};
+    hibf_layout.user_bins.emplace_back(std::vector<size_t>{}, 0u, 1u, 0u);
+    hibf_layout.user_bins.emplace_back(std::vector<size_t>{}, 1u, 1u, 1u);
+    hibf_layout.user_bins.emplace_back(std::vector<size_t>{2u}, 0u, 1u, 2u);
+    hibf_layout.user_bins.emplace_back(std::vector<size_t>{2u}, 1u, 1u, 3u);
+    hibf_layout.max_bins.emplace_back(std::vector<size_t>{5u}, 0u); // outdated
+
+    chopper::layout::update_max_bins(config, hibf_layout, kmer_counts, sketches);
+
+    EXPECT_EQ(hibf_layout.top_level_max_bin_id, 2u);
+    EXPECT_EQ(hibf_layout.max_bins, (std::vector<max_bin_t>{{{2u}, 1u}}));
+}
+
+TEST(stable_layout_test, carry_over_layout)
+{
+    chopper::configuration config{};
+    config.hibf_config.tmax = 64u;
+    config.hibf_config.disable_estimate_union = true;
+
+    std::vector<std::vector<std::string>> const previous_filenames{{"a"}, {"b"}, {"c"}};
+    seqan::hibf::layout::layout previous_layout{};
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{}, 0u, 2u, 0u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{2u}, 0u, 1u, 1u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{2u}, 1u, 1u, 2u);
+
+    // "b" was removed and "d" was added.
+    std::vector<std::vector<std::string>> const filenames{{"c"}, {"a"}, {"d"}};
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches(3u);
+    std::vector<size_t> const kmer_counts{100u, 100u, 100u};
+
+    std::optional<seqan::hibf::layout::layout> const hibf_layout =
+        chopper::layout::carry_over_layout(config,
+                                           previous_filenames,
+                                           previous_layout,
+                                           filenames,
+                                           kmer_counts,
+                                           sketches,
+                                           {});
+
+    // "c" and "a" keep their technical bins, "d" gets the first unused technical bin of the top-level IBF.
+    ASSERT_TRUE(hibf_layout.has_value());
+    EXPECT_EQ(hibf_layout->user_bins,
+              (std::vector<user_bin_t>{{{2u}, 1u, 1u, 0u}, {{}, 0u, 2u, 1u}, {{}, 3u, 1u, 2u}}));
+    EXPECT_EQ(hibf_layout->max_bins, (std::vector<max_bin_t>{{{2u}, 1u}}));
+
+    // A pinned user bin must not stay in a merged bin.
+    EXPECT_FALSE(chopper::layout::carry_over_layout(config,
+                                                    previous_filenames,
+                                                    previous_layout,
+                                                    filenames,
+                                                    kmer_counts,
+                                                    sketches,
+                                                    {1u, 0u, 0u})
+                     .has_value());
+
+    // There is no unused technical bin in the top-level IBF. "d" takes the technical bin of "b" in the merged bin.
+    config.hibf_config.tmax = 3u;
+    std::optional<seqan::hibf::layout::layout> const merged_layout =
+        chopper::layout::carry_over_layout(config,
+                                           previous_filenames,
+                                           previous_layout,
+                                           filenames,
+                                           kmer_counts,
+                                           sketches,
+                                           {});
+
+    ASSERT_TRUE(merged_layout.has_value());
+    EXPECT_EQ(merged_layout->user_bins,
+              (std::vector<user_bin_t>{{{2u}, 1u, 1u, 0u}, {{}, 0u, 2u, 1u}, {{2u}, 0u, 1u, 2u}}));
+
+    // User bins with the same filenames cannot be told apart.
+    config.hibf_config.tmax = 64u;
+    std::vector<std::vector<std::string>> const duplicate_filenames{{"c"}, {"a"}, {"a"}};
+    EXPECT_FALSE(chopper::layout::carry_over_layout(config,
+                                                    previous_filenames,
+                                                    previous_layout,
+                                                    duplicate_filenames,
+                                                    kmer_counts,
+                                                    sketches,
+                                                    {})
+                     .has_value());
+
+    std::vector<std::vector<std::string>> const duplicate_previous_filenames{{"a"}, {"b"}, {"a"}};
+    EXPECT_FALSE(chopper::layout::carry_over_layout(config,
+                                                    duplicate_previous_filenames,
+                                                    previous_layout,
+                                                    filenames,
+                                                    kmer_counts,
+                                                    sketches,
+                                                    {})
+                     .has_value());
+}
+
+TEST(stable_layout_test, carry_over_layout_adds_user_bins)
+{
+    chopper::configuration config{};
+    config.hibf_config.tmax = 4u;
+    config.hibf_config.disable_estimate_union = true;
+
+    // All technical bins of the top-level IBF are used.
+    std::vector<std::vector<std::string>> const previous_filenames{{"a"}, {"b"}, {"c"}, {"d"}};
+    seqan::hibf::layout::layout previous_layout{};
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{}, 0u, 2u, 0u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{2u}, 0u, 2u, 1u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{2u}, 2u, 1u, 2u);
+    previous_layout.user_bins.emplace_back(std::vector<size_t>{}, 3u, 1u, 3u);
+
+    // No user bin was removed and "e", "f" and "g" were added.
+    std::vector<std::vector<std::string>> filenames{{"a"}, {"b"}, {"c"}, {"d"}, {"e"}, {"f"}, {"g"}};
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches(7u);
+    std::vector<size_t> kmer_counts(7u, 100u);
+
+    auto carry_over = [&](std::vector<size_t> const & priorities)
+    {
+        return chopper::layout::carry_over_layout(config,
+                                                  previous_filenames,
+                                                  previous_layout,
+                                                  filenames,
+                                                  kmer_counts,
+                                                  sketches,
+                                                  priorities);
+    };
+
+    // "e" gets the unused technical bin of the merged bin, "f" takes the last technical bin of "b" in the merged bin,
+    // and "g" takes the last technical bin of "a" in the top-level IBF.
+    std::optional<seqan::hibf::layout::layout> const hibf_layout = carry_over({});
+
+    ASSERT_TRUE(hibf_layout.has_value());
+    EXPECT_EQ(hibf_layout->user_bins,
+              (std::vector<user_bin_t>{{{}, 0u, 1u, 0u},
+                                       {{2u}, 0u, 1u, 1u},
+                                       {{2u}, 2u, 1u, 2u},
+                                       {{}, 3u, 1u, 3u},
+                                       {{2u}, 3u, 1u, 4u},
+                                       {{2u}, 1u, 1u, 5u},
+                                       {{}, 1u, 1u, 6u}}));
+
+    // A pinned user bin keeps its technical bins, so there is no technical bin left for "g".
+    EXPECT_FALSE(carry_over({1u, 0u, 0u, 0u, 0u, 0u, 0u}).has_value());
+
+    // There is no technical bin left for "h".
+    filenames.push_back({"h"});
+    sketches.emplace_back();
+    kmer_counts.push_back(100u);
+    EXPECT_FALSE(carry_over({}).has_value());
+}
@@ -0,0 +1,89 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/sweep.hpp>
+
+#include <hibf/sketch/compute_sketches.hpp>
+#include <hibf/sketch/estimate_kmer_counts.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+TEST(sweep_test, grid)
+{
+    auto simulated_input = [&](size_t const num, seqan::hibf::insert_iterator it)
+    {
+        size_t const desired_kmer_count = 101 * ((num + 20) / 20) + num;
+        for (auto hash : std::views::iota(0u, desired_kmer_count))
+            it = hash;
+    };
+
+    chopper::configuration config{};
+    config.hibf_config.input_fn = simulated_input;
+    config.hibf_config.number_of_user_bins = 96u;
+    config.hibf_config.disable_estimate_union = true; // also disables rearrangement
+    config.sweep_fprs = {0.01, 0.05};
+    config.sweep_relaxed_fprs = {0.005, 0.3}; // 0.005 is invalid for fpr = 0.01
+    config.sweep_tmaxs = {64u, 128u};
+
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches;
+    seqan::hibf::sketch::compute_sketches(config.hibf_config, sketches);
+    std::vector<size_t> kmer_counts;
+    seqan::hibf::sketch::estimate_kmer_counts(sketches, kmer_counts);
+
+    auto const results = chopper::layout::sweep(config, kmer_counts, sketches);
+    ASSERT_EQ(results.size(), 8u);
+
+    // The results are in the order of the nested loops.
+    EXPECT_EQ(results[0].fpr, 0.01);
+    EXPECT_EQ(results[0].relaxed_fpr, 0.005);
+    EXPECT_EQ(results[0].tmax, 64u);
+    EXPECT_FALSE(results[0].valid);
+    EXPECT_FALSE(results[1].valid);
+    EXPECT_EQ(results[7].fpr, 0.05);
+    EXPECT_EQ(results[7].relaxed_fpr, 0.3);
+    EXPECT_EQ(results[7].tmax, 128u);
+
+    for (size_t i = 2; i < results.size(); ++i)
+    {
+        EXPECT_TRUE(results[i].valid) << i;
+        EXPECT_EQ(results[i].hash_functions, config.hibf_config.number_of_hash_functions);
+        EXPECT_EQ(results[i].alpha, config.hibf_config.alpha);
+        EXPECT_GT(results[i].size_in_bytes, 0u);
+    }
+
+    // 96 user bins need two levels with tmax = 64, but only one with tmax = 128.
+    EXPECT_EQ(results[6].levels, 2u);
+    EXPECT_EQ(results[7].levels, 1u);
+
+    // A higher FPR needs less memory.
+    EXPECT_LT(results[7].size_in_bytes, results[3].size_in_bytes);
+
+    // The results do not depend on the number of threads.
+    config.hibf_config.threads = 4u;
+    auto const parallel_results = chopper::layout::sweep(config, kmer_counts, sketches);
+    ASSERT_EQ(parallel_results.size(), results.size());
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        EXPECT_EQ(parallel_results[i].size_in_bytes, results[i].size_in_bytes) << i;
+        EXPECT_EQ(parallel_results[i].expected_query_cost, results[i].expected_query_cost) << i;
+    }
+
+    std::ostringstream table{};
+    chopper::layout::write_sweep_table_to(table, results);
+    std::string const expected_first_lines{"# fpr\trelaxed_fpr\thash\talpha\ttmax\tlevels\tsize_in_bytes\tsize\t"
+                                           "expected_query_cost\n"
+                                           "0.01\t0.005\t2\t1.2\t64\tNA\tNA\tNA\tNA\n"};
+    EXPECT_TRUE(table.str().starts_with(expected_first_lines)) << table.str();
+}
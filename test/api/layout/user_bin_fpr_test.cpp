@@ -0,0 +1,70 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/layout/user_bin_fpr.hpp>
+
+TEST(user_bin_fpr_test, user_bin_fpr)
+{
+    chopper::configuration config{};
+    config.hibf_config.maximum_fpr = 0.05;
+
+    // Without FPRs, all user bins use the maximum FPR.
+    EXPECT_EQ(chopper::layout::user_bin_fpr(config, 0u), 0.05);
+
+    config.user_bin_fprs = {0.001, 0.0};
+    EXPECT_EQ(chopper::layout::user_bin_fpr(config, 0u), 0.001);
+    EXPECT_EQ(chopper::layout::user_bin_fpr(config, 1u), 0.05);
+    EXPECT_EQ(chopper::layout::user_bin_fpr(config, 2u), 0.05);
+}
+
+TEST(user_bin_fpr_test, use_strictest_fpr)
+{
+    chopper::configuration config{};
+    config.hibf_config.maximum_fpr = 0.05;
+    config.hibf_config.number_of_user_bins = 3u;
+
+    // Without FPRs, the maximum FPR does not change.
+    chopper::layout::use_strictest_fpr(config);
+    EXPECT_EQ(config.hibf_config.maximum_fpr, 0.05);
+
+    // A user bin with a stricter FPR.
+    config.user_bin_fprs = {0.0, 0.001, 0.1};
+    chopper::layout::use_strictest_fpr(config);
+    EXPECT_EQ(config.hibf_config.maximum_fpr, 0.001);
+
+    // If all user bins have an FPR, --fpr does not matter.
+    config.hibf_config.maximum_fpr = 0.05;
+    config.user_bin_fprs = {0.2, 0.1, 0.1};
+    chopper::layout::use_strictest_fpr(config);
+    EXPECT_EQ(config.hibf_config.maximum_fpr, 0.1);
+
+    // Only the first number_of_user_bins user bins count.
+    config.hibf_config.maximum_fpr = 0.05;
+    config.user_bin_fprs = {0.0, 0.1, 0.1, 0.001};
+    chopper::layout::use_strictest_fpr(config);
+    EXPECT_EQ(config.hibf_config.maximum_fpr, 0.05);
+}
+
+TEST(user_bin_fpr_test, fpr_classes)
+{
+    chopper::configuration config{};
+    config.hibf_config.maximum_fpr = 0.05;
+    config.hibf_config.number_of_user_bins = 4u;
+
+    // Without FPRs, all user bins are in one class.
+    EXPECT_EQ(chopper::layout::fpr_classes(config), (std::vector<std::vector<size_t>>{{0u, 1u, 2u, 3u}}));
+
+    // The strictest FPR comes first. User bins without an FPR use --fpr.
+    config.user_bin_fprs = {0.1, 0.001, 0.0, 0.1};
+    EXPECT_EQ(chopper::layout::fpr_classes(config), (std::vector<std::vector<size_t>>{{1u}, {2u}, {0u, 3u}}));
+}
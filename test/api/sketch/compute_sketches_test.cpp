@@ -0,0 +1,61 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/input_functor.hpp>
+#include <chopper/sketch/compute_sketches.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
+
+#include <hibf/contrib/robin_hood.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+#include "../api_test.hpp"
+
+TEST(compute_sketches_test, multiple_files_per_user_bin)
+{
+    std::vector<std::vector<std::string>> filenames{{data("seq1.fa").string(), data("seq2.fa").string()},
+                                                    {data("seq3.fa").string()},
+                                                    {data("seq1.fa").string(), data("seq3.fa").string()}};
+
+    chopper::configuration config{};
+    config.k = 15;
+    config.window_size = 15;
+    config.hibf_config.threads = 4u;
+    chopper::filename_store const store = chopper::make_filename_store(filenames);
+    config.hibf_config.input_fn = chopper::input_functor{store, false, config.k, config.window_size};
+
+    // Copies of the configuration share the filenames.
+    chopper::configuration const config_copy{config};
+    ASSERT_NE(config_copy.hibf_config.input_fn.target<chopper::input_functor>(), nullptr);
+    EXPECT_EQ(config_copy.hibf_config.input_fn.target<chopper::input_functor>()->filenames, store);
+
+    std::vector<chopper::sketch::sparse_hyperloglog> sketches{};
+    chopper::sketch::compute_sketches(config, sketches);
+
+    ASSERT_EQ(sketches.size(), filenames.size());
+
+    // Sketching all files of a user bin sequentially must give the same result.
+    chopper::input_functor input_fn{store, false, config.k, config.window_size};
+
+    for (size_t ub = 0; ub < filenames.size(); ++ub)
+    {
+        robin_hood::unordered_flat_set<uint64_t> hashes{};
+        input_fn(ub, seqan::hibf::insert_iterator{hashes});
+
+        seqan::hibf::sketch::hyperloglog expected{config.hibf_config.sketch_bits};
+        for (uint64_t const hash : hashes)
+            expected.add(hash);
+
+        EXPECT_EQ(sketches[ub].estimate(), expected.estimate());
+    }
+}
@@ -0,0 +1,58 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <chopper/configuration.hpp>
+#include <chopper/input_functor.hpp>
+#include <chopper/sketch/estimate_query_hits.hpp>
+
+#include <hibf/contrib/robin_hood.hpp>
+#include <hibf/sketch/hyperloglog.hpp>
+
+#include "../api_test.hpp"
+
+TEST(estimate_query_hits_test, sample_is_a_user_bin)
+{
+    std::vector<std::vector<std::string>> filenames{{data("seq1.fa").string()},
+                                                    {data("seq2.fa").string()},
+                                                    {data("seq1.fa").string(), data("seq3.fa").string()}};
+
+    chopper::configuration config{};
+    config.k = 15;
+    config.window_size = 15;
+    config.query_sample = data("seq1.fa");
+
+    chopper::input_functor input_fn{chopper::make_filename_store(filenames), false, config.k, config.window_size};
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches{};
+
+    for (size_t ub = 0; ub < filenames.size(); ++ub)
+    {
+        robin_hood::unordered_flat_set<uint64_t> hashes{};
+        input_fn(ub, seqan::hibf::insert_iterator{hashes});
+
+        sketches.emplace_back(config.hibf_config.sketch_bits);
+        for (uint64_t const hash : hashes)
+            sketches.back().add(hash);
+    }
+
+    std::vector<double> const hits = chopper::sketch::estimate_query_hits(config, sketches);
+
+    ASSERT_EQ(hits.size(), filenames.size());
+
+    // The sample is exactly user bin 0, so all of its k-mers are hits.
+    EXPECT_DOUBLE_EQ(hits[0], sketches[0].estimate());
+    // User bin 2 contains the sample as well.
+    EXPECT_NEAR(hits[2], hits[0], 0.05 * hits[0]);
+
+    for (double const hit : hits)
+        EXPECT_GE(hit, 0.0);
+}
@@ -0,0 +1,56 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <chopper/sketch/hyperloglog_registers.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+// The upper 5 bits of a value select the register, the number of leading zeros of the remaining bits plus 1 is the
+// value of the register. If this test fails, the serialised form of seqan::hibf::sketch::hyperloglog has changed.
+TEST(hyperloglog_registers_test, register_format)
+{
+    seqan::hibf::sketch::hyperloglog sketch{5u};
+    sketch.add((3ULL << 59) | (1ULL << 50)); // register 3, 8 leading zeros
+    sketch.add((3ULL << 59) | (1ULL << 57)); // register 3, 1 leading zero
+    sketch.add((31ULL << 59) | 1ULL);        // register 31, 58 leading zeros
+
+    std::vector<uint8_t> expected(32u, 0u);
+    expected[3] = 9u;
+    expected[31] = 59u;
+
+    EXPECT_EQ(chopper::sketch::registers_of(sketch), expected);
+    EXPECT_EQ(chopper::sketch::registers_of(chopper::sketch::to_hyperloglog(expected)), expected);
+    EXPECT_EQ(chopper::sketch::to_hyperloglog(expected).estimate(), sketch.estimate());
+}
+
+TEST(hyperloglog_registers_test, estimate)
+{
+    std::mt19937_64 engine{42u};
+
+    for (uint8_t const bits : {5u, 12u})
+    {
+        for (size_t const number_of_values : {0u, 10u, 1000u, 100000u})
+        {
+            seqan::hibf::sketch::hyperloglog sketch{bits};
+            for (size_t i = 0; i < number_of_values; ++i)
+                sketch.add(engine());
+
+            chopper::sketch::hyperloglog_estimator estimator{sketch.data_size()};
+            for (uint8_t const value : chopper::sketch::registers_of(sketch))
+                estimator.add(value);
+
+            // The sum of the estimate may be rounded differently than in seqan::hibf::sketch::hyperloglog.
+            EXPECT_NEAR(estimator.estimate(), sketch.estimate(), sketch.estimate() * 1e-4) << number_of_values;
+        }
+    }
+}
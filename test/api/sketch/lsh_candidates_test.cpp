@@ -0,0 +1,93 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <chopper/sketch/lsh_candidates.hpp>
+#include <chopper/splitmix64.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+// There are 3 clusters of 4 user bins each. The user bins of a cluster share 20000 values and have 1000 own values.
+// User bins of different clusters are disjoint.
+std::vector<seqan::hibf::sketch::hyperloglog> clustered_sketches()
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches{};
+
+    for (uint64_t cluster = 0; cluster < 3u; ++cluster)
+    {
+        for (uint64_t member = 0; member < 4u; ++member)
+        {
+            seqan::hibf::sketch::hyperloglog sketch{12u};
+            uint64_t const shared_begin{cluster * 1'000'000u};
+            uint64_t const own_begin{shared_begin + 100'000u + member * 1000u};
+
+            for (uint64_t value : std::views::iota(shared_begin, shared_begin + 20'000u))
+                sketch.add(chopper::splitmix64(value));
+            for (uint64_t value : std::views::iota(own_begin, own_begin + 1000u))
+                sketch.add(chopper::splitmix64(value));
+
+            sketches.push_back(std::move(sketch));
+        }
+    }
+
+    return sketches;
+}
+
+TEST(lsh_candidates_test, clusters)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = clustered_sketches();
+    std::vector<std::pair<size_t, size_t>> const candidates = chopper::sketch::lsh_candidate_pairs(sketches);
+
+    EXPECT_TRUE(std::ranges::is_sorted(candidates));
+    EXPECT_EQ(std::ranges::adjacent_find(candidates), candidates.end());
+
+    size_t pairs_within_clusters{};
+    for (auto const & [i, j] : candidates)
+    {
+        EXPECT_LT(i, j);
+        pairs_within_clusters += (i / 4u == j / 4u);
+    }
+
+    // All 6 pairs of each cluster are found. Pairs of different clusters are rare.
+    EXPECT_EQ(pairs_within_clusters, 3u * 6u);
+    EXPECT_LE(candidates.size() - pairs_within_clusters, 4u);
+}
+
+TEST(lsh_candidates_test, threads)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = clustered_sketches();
+
+    EXPECT_EQ(chopper::sketch::lsh_candidate_pairs(sketches, 8u, 1u),
+              chopper::sketch::lsh_candidate_pairs(sketches, 8u, 4u));
+}
+
+TEST(lsh_candidates_test, empty_sketches)
+{
+    // Empty registers are not similar.
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches(5u, seqan::hibf::sketch::hyperloglog{12u});
+
+    EXPECT_TRUE(chopper::sketch::lsh_candidate_pairs(sketches).empty());
+    EXPECT_TRUE(chopper::sketch::lsh_candidate_pairs({}).empty());
+}
+
+TEST(lsh_candidates_test, invalid_arguments)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches = clustered_sketches();
+
+    EXPECT_THROW((void)chopper::sketch::lsh_candidate_pairs(sketches, 0u), std::invalid_argument);
+
+    sketches.push_back(seqan::hibf::sketch::hyperloglog{10u});
+    EXPECT_THROW((void)chopper::sketch::lsh_candidate_pairs(sketches), std::invalid_argument);
+}
@@ -22,27 +22,25 @@
 TEST(read_data_file_test, file_open_error)
 {
     chopper::configuration config{};
-    std::vector<std::vector<std::string>> filenames{};
     config.data_file = data("non_existing.file");
-    EXPECT_THROW(chopper::sketch::read_data_file(config, filenames), std::runtime_error);
+    EXPECT_THROW((void)chopper::sketch::read_data_file(config), std::runtime_error);
 }
 
 TEST(read_data_file_test, small_example)
 {
     chopper::configuration config;
-    std::vector<std::vector<std::string>> filenames{};
     config.data_file = data("seqinfo.tsv");
 
-    chopper::sketch::read_data_file(config, filenames);
+    chopper::sketch::data_file_content const content = chopper::sketch::read_data_file(config);
 
     std::vector<std::vector<std::string>> expected_filenames{{"file1"}, {"file2"}, {"file3"}, {"file4"}, {"file5"}};
-    EXPECT_RANGE_EQ(filenames, expected_filenames);
+    EXPECT_RANGE_EQ(content.filenames, expected_filenames);
+    EXPECT_RANGE_EQ(content.user_bin_indices, (std::vector<size_t>{0u, 1u, 2u, 3u, 4u}));
 }
 
 TEST(read_data_file_test, multi_filenames)
 {
     chopper::configuration config;
-    std::vector<std::vector<std::string>> filenames{};
 
     seqan3::test::tmp_directory tmp_dir{};
     config.data_file = tmp_dir.path() / "multi_files.txt";
@@ -52,10 +50,152 @@ TEST(read_data_file_test, multi_filenames)
         of << "file1a file1b\nfile2\nfile3a file3b file3c\n";
     }
 
-    chopper::sketch::read_data_file(config, filenames);
+    chopper::sketch::data_file_content const content = chopper::sketch::read_data_file(config);
 
     std::vector<std::vector<std::string>> expected_filenames{{"file1a", "file1b"},
                                                              {"file2"},
                                                              {"file3a", "file3b", "file3c"}};
-    EXPECT_RANGE_EQ(filenames, expected_filenames);
+    EXPECT_RANGE_EQ(content.filenames, expected_filenames);
+}
+
+TEST(read_data_file_test, shards)
+{
+    chopper::configuration config;
+    config.data_file = data("seqinfo.tsv");
+    config.number_of_shards = 3u;
+
+    std::vector<std::vector<std::string>> all_filenames{};
+
+    for (size_t i = 0; i < config.number_of_shards; ++i)
+    {
+        config.shard_index = i;
+        std::vector<std::vector<std::string>> const filenames = chopper::sketch::read_data_file(config).filenames;
+        EXPECT_FALSE(filenames.empty());
+        all_filenames.insert(all_filenames.end(), filenames.begin(), filenames.end());
+    }
+
+    std::vector<std::vector<std::string>> expected_filenames{{"file1"}, {"file2"}, {"file3"}, {"file4"}, {"file5"}};
+    EXPECT_RANGE_EQ(all_filenames, expected_filenames);
+}
+
+TEST(read_data_file_test, shards_by_hash)
+{
+    chopper::configuration config;
+    config.data_file = data("seqinfo.tsv");
+    config.number_of_shards = 3u;
+    config.shard_by_hash = true;
+
+    std::vector<std::vector<std::string>> all_filenames(5);
+    std::vector<size_t> number_of_occurrences(5, 0u);
+
+    for (size_t i = 0; i < config.number_of_shards; ++i)
+    {
+        config.shard_index = i;
+        chopper::sketch::data_file_content const content = chopper::sketch::read_data_file(config);
+        ASSERT_EQ(content.filenames.size(), content.user_bin_indices.size());
+
+        for (size_t j = 0; j < content.filenames.size(); ++j)
+        {
+            ASSERT_LT(content.user_bin_indices[j], 5u);
+            ++number_of_occurrences[content.user_bin_indices[j]];
+            all_filenames[content.user_bin_indices[j]] = content.filenames[j];
+        }
+
+        // The assignment is deterministic.
+        EXPECT_RANGE_EQ(chopper::sketch::read_data_file(config).user_bin_indices, content.user_bin_indices);
+    }
+
+    std::vector<std::vector<std::string>> expected_filenames{{"file1"}, {"file2"}, {"file3"}, {"file4"}, {"file5"}};
+    EXPECT_RANGE_EQ(all_filenames, expected_filenames);
+    EXPECT_RANGE_EQ(number_of_occurrences, (std::vector<size_t>(5, 1u)));
+}
+
+TEST(read_data_file_test, priorities)
+{
+    chopper::configuration config;
+
+    seqan3::test::tmp_directory tmp_dir{};
+    config.data_file = tmp_dir.path() / "priorities.txt";
+
+    {
+        std::ofstream of{config.data_file};
+        of << "file1\tpriority=2\n"
+              "file2\n"
+              "file3a file3b\t500\tpriority=1\n"
+              "file4\tpriority=0\n";
+    }
+
+    chopper::sketch::data_file_content content = chopper::sketch::read_data_file(config);
+
+    std::vector<std::vector<std::string>> expected_filenames{{"file1"}, {"file2"}, {"file3a", "file3b"}, {"file4"}};
+    EXPECT_RANGE_EQ(content.filenames, expected_filenames);
+    EXPECT_RANGE_EQ(content.priorities, (std::vector<size_t>{2u, 0u, 1u, 0u}));
+
+    // Shards keep the priorities of their user bins.
+    config.number_of_shards = 2u;
+    config.shard_index = 1u;
+    content = chopper::sketch::read_data_file(config);
+    EXPECT_RANGE_EQ(content.user_bin_indices, (std::vector<size_t>{2u, 3u}));
+    EXPECT_RANGE_EQ(content.priorities, (std::vector<size_t>{1u, 0u}));
+}
+
+TEST(read_data_file_test, invalid_priority)
+{
+    chopper::configuration config;
+
+    seqan3::test::tmp_directory tmp_dir{};
+    config.data_file = tmp_dir.path() / "priorities.txt";
+
+    {
+        std::ofstream of{config.data_file};
+        of << "file1\tpriority=high\n";
+    }
+
+    EXPECT_THROW((void)chopper::sketch::read_data_file(config), std::runtime_error);
+}
+
+TEST(read_data_file_test, fprs)
+{
+    chopper::configuration config;
+
+    seqan3::test::tmp_directory tmp_dir{};
+    config.data_file = tmp_dir.path() / "fprs.txt";
+
+    {
+        std::ofstream of{config.data_file};
+        of << "file1\tfpr=0.001\n"
+              "file2\n"
+              "file3\tpriority=1\tfpr=0.05\n"
+              "file4\tfpr=1e-4\n";
+    }
+
+    chopper::sketch::data_file_content content = chopper::sketch::read_data_file(config);
+
+    EXPECT_RANGE_EQ(content.priorities, (std::vector<size_t>{0u, 0u, 1u, 0u}));
+    EXPECT_RANGE_EQ(content.fprs, (std::vector<double>{0.001, 0.0, 0.05, 0.0001}));
+
+    // Shards keep the FPRs of their user bins.
+    config.number_of_shards = 2u;
+    config.shard_index = 0u;
+    content = chopper::sketch::read_data_file(config);
+    EXPECT_RANGE_EQ(content.user_bin_indices, (std::vector<size_t>{0u, 1u}));
+    EXPECT_RANGE_EQ(content.fprs, (std::vector<double>{0.001, 0.0}));
+}
+
+TEST(read_data_file_test, invalid_fpr)
+{
+    chopper::configuration config;
+
+    seqan3::test::tmp_directory tmp_dir{};
+    config.data_file = tmp_dir.path() / "fprs.txt";
+
+    for (std::string const fpr : {"low", "0", "1", "-0.1", "0.05x"})
+    {
+        {
+            std::ofstream of{config.data_file};
+            of << "file1\tfpr=" << fpr << '\n';
+        }
+
+        EXPECT_THROW((void)chopper::sketch::read_data_file(config), std::runtime_error);
+    }
 }
@@ -0,0 +1,149 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+#include <seqan3/test/tmp_directory.hpp>
+
+#include <chopper/sketch/similarity_store.hpp>
+#include <chopper/splitmix64.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+// User bin i contains the values [1000 * i, 1000 * i + 4000). Neighbouring user bins share most values.
+std::vector<seqan::hibf::sketch::hyperloglog> overlapping_sketches()
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches{};
+
+    for (uint64_t i = 0; i < 6u; ++i)
+    {
+        seqan::hibf::sketch::hyperloglog sketch{12u};
+        for (uint64_t value : std::views::iota(1000u * i, 1000u * i + 4000u))
+            sketch.add(chopper::splitmix64(value));
+        sketches.push_back(std::move(sketch));
+    }
+
+    return sketches;
+}
+
+TEST(similarity_store_test, neighbours)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = overlapping_sketches();
+    chopper::sketch::similarity_store const store{sketches, 2u};
+
+    ASSERT_EQ(store.size(), sketches.size());
+    EXPECT_EQ(store.neighbours_per_user_bin(), 2u);
+
+    // The first user bin shares 3000 values with the second and 2000 with the third.
+    auto const first = store.neighbours(0u);
+    ASSERT_EQ(first.size(), 2u);
+    EXPECT_EQ(first[0].index, 1u);
+    EXPECT_EQ(first[1].index, 2u);
+    EXPECT_NEAR(first[0].similarity, 3.0 / 5.0, 0.1);
+    EXPECT_GT(first[0].similarity, first[1].similarity);
+
+    // The other user bins have two neighbours that share 3000 values.
+    for (size_t i = 1u; i < 5u; ++i)
+    {
+        auto const neighbours = store.neighbours(i);
+        ASSERT_EQ(neighbours.size(), 2u);
+        EXPECT_TRUE((neighbours[0].index == i - 1u && neighbours[1].index == i + 1u)
+                    || (neighbours[0].index == i + 1u && neighbours[1].index == i - 1u));
+    }
+}
+
+TEST(similarity_store_test, no_similarity)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> sketches = overlapping_sketches();
+    sketches.erase(sketches.begin() + 1u, sketches.begin() + 5u); // The first and the last user bin are disjoint.
+
+    chopper::sketch::similarity_store const store{sketches, 2u};
+
+    ASSERT_EQ(store.size(), 2u);
+    EXPECT_TRUE(store.neighbours(0u).empty());
+    EXPECT_TRUE(store.neighbours(1u).empty());
+}
+
+TEST(similarity_store_test, candidates)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = overlapping_sketches();
+
+    // Only the candidate pairs are compared. The disjoint pair (0, 5) is not a neighbour.
+    std::vector<std::pair<size_t, size_t>> const candidates{{0u, 2u}, {0u, 5u}, {3u, 4u}};
+    chopper::sketch::similarity_store const store{sketches, candidates, 2u};
+
+    ASSERT_EQ(store.size(), sketches.size());
+
+    ASSERT_EQ(store.neighbours(0u).size(), 1u);
+    EXPECT_EQ(store.neighbours(0u)[0].index, 2u);
+    ASSERT_EQ(store.neighbours(2u).size(), 1u);
+    EXPECT_EQ(store.neighbours(2u)[0].index, 0u);
+    EXPECT_EQ(store.neighbours(2u)[0].similarity, store.neighbours(0u)[0].similarity);
+
+    ASSERT_EQ(store.neighbours(3u).size(), 1u);
+    EXPECT_EQ(store.neighbours(3u)[0].index, 4u);
+    ASSERT_EQ(store.neighbours(4u).size(), 1u);
+    EXPECT_EQ(store.neighbours(4u)[0].index, 3u);
+
+    EXPECT_TRUE(store.neighbours(1u).empty());
+    EXPECT_TRUE(store.neighbours(5u).empty());
+}
+
+TEST(similarity_store_test, threads)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = overlapping_sketches();
+    chopper::sketch::similarity_store const serial{sketches, 3u, 1u};
+    chopper::sketch::similarity_store const parallel{sketches, 3u, 4u};
+
+    ASSERT_EQ(parallel.size(), serial.size());
+    for (size_t i = 0; i < serial.size(); ++i)
+        EXPECT_TRUE(std::ranges::equal(parallel.neighbours(i), serial.neighbours(i))) << i;
+}
+
+TEST(similarity_store_test, write_and_read)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const sketch_file{tmp_dir.path() / "all.sketch"};
+
+    std::vector<seqan::hibf::sketch::hyperloglog> const sketches = overlapping_sketches();
+    chopper::sketch::similarity_store const expected{sketches, 3u};
+
+    EXPECT_EQ(chopper::sketch::similarity_store_path(sketch_file), tmp_dir.path() / "all.similarities");
+    EXPECT_FALSE(chopper::sketch::read_similarity_store_next_to(sketch_file, sketches).has_value());
+
+    chopper::sketch::write_similarity_store_next_to(sketch_file, sketches, 3u, 1u);
+
+    // A store for a different number of user bins is not used.
+    std::vector<seqan::hibf::sketch::hyperloglog> more_sketches = sketches;
+    more_sketches.push_back(sketches.back());
+    EXPECT_FALSE(chopper::sketch::read_similarity_store_next_to(sketch_file, more_sketches).has_value());
+
+    // A store for the same number of user bins but different sketches is not used.
+    std::vector<seqan::hibf::sketch::hyperloglog> other_sketches = sketches;
+    for (uint64_t value : std::views::iota(10000u, 11000u))
+        other_sketches[2].add(chopper::splitmix64(value));
+    EXPECT_FALSE(chopper::sketch::read_similarity_store_next_to(sketch_file, other_sketches).has_value());
+
+    // A store for sketches with a different number of bits is not used.
+    std::vector<seqan::hibf::sketch::hyperloglog> const coarse_sketches(sketches.size(),
+                                                                        seqan::hibf::sketch::hyperloglog{5u});
+    EXPECT_FALSE(chopper::sketch::read_similarity_store_next_to(sketch_file, coarse_sketches).has_value());
+
+    auto const store = chopper::sketch::read_similarity_store_next_to(sketch_file, sketches);
+    ASSERT_TRUE(store.has_value());
+    ASSERT_EQ(store->size(), expected.size());
+    EXPECT_EQ(store->neighbours_per_user_bin(), 3u);
+    for (size_t i = 0; i < expected.size(); ++i)
+        EXPECT_TRUE(std::ranges::equal(store->neighbours(i), expected.neighbours(i))) << i;
+}
@@ -0,0 +1,123 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <cereal/archives/binary.hpp>
+
+#include <chopper/sketch/sparse_hyperloglog.hpp>
+
+#include <hibf/sketch/hyperloglog.hpp>
+
+seqan::hibf::sketch::hyperloglog random_sketch(size_t const number_of_values, uint64_t const seed)
+{
+    std::mt19937_64 engine{seed};
+    seqan::hibf::sketch::hyperloglog sketch{12};
+
+    for (size_t i = 0; i < number_of_values; ++i)
+        sketch.add(engine());
+
+    return sketch;
+}
+
+TEST(sparse_hyperloglog_test, empty)
+{
+    chopper::sketch::sparse_hyperloglog sketch{12};
+
+    EXPECT_TRUE(sketch.is_sparse());
+    EXPECT_EQ(sketch.data_size(), 4096u);
+    EXPECT_EQ(sketch.memory_usage(), 0u);
+    EXPECT_EQ(sketch.estimate(), seqan::hibf::sketch::hyperloglog{12}.estimate());
+}
+
+TEST(sparse_hyperloglog_test, conversion_is_lossless)
+{
+    for (size_t const number_of_values : {10u, 100u, 1000u, 100000u})
+    {
+        seqan::hibf::sketch::hyperloglog const dense = random_sketch(number_of_values, number_of_values);
+        chopper::sketch::sparse_hyperloglog const sparse{dense};
+
+        EXPECT_EQ(sparse.is_sparse(), number_of_values < 512u) << number_of_values;
+        EXPECT_LE(sparse.memory_usage(), sparse.data_size());
+        EXPECT_EQ(sparse.to_hyperloglog().estimate(), dense.estimate());
+        // The sum of the estimate may be rounded differently than in seqan::hibf::sketch::hyperloglog.
+        EXPECT_NEAR(sparse.estimate(), dense.estimate(), dense.estimate() * 1e-4) << number_of_values;
+    }
+}
+
+TEST(sparse_hyperloglog_test, merge)
+{
+    for (size_t const number_of_values : {10u, 300u, 100000u})
+    {
+        seqan::hibf::sketch::hyperloglog dense1 = random_sketch(number_of_values, 1u);
+        seqan::hibf::sketch::hyperloglog const dense2 = random_sketch(number_of_values, 2u);
+
+        chopper::sketch::sparse_hyperloglog sparse1{dense1};
+        chopper::sketch::sparse_hyperloglog const sparse2{dense2};
+        sparse1.merge(sparse2);
+        dense1.merge(dense2);
+
+        EXPECT_NEAR(sparse1.estimate(), dense1.estimate(), dense1.estimate() * 1e-4) << number_of_values;
+    }
+
+    // Merging a sparse and a dense sketch.
+    seqan::hibf::sketch::hyperloglog small = random_sketch(10u, 3u);
+    seqan::hibf::sketch::hyperloglog const large = random_sketch(100000u, 4u);
+    chopper::sketch::sparse_hyperloglog sparse_small{small};
+    sparse_small.merge(chopper::sketch::sparse_hyperloglog{large});
+    small.merge(large);
+
+    EXPECT_FALSE(sparse_small.is_sparse());
+    EXPECT_NEAR(sparse_small.estimate(), small.estimate(), small.estimate() * 1e-4);
+
+    chopper::sketch::sparse_hyperloglog different_size{10};
+    EXPECT_THROW(sparse_small.merge(different_size), std::invalid_argument);
+}
+
+TEST(sparse_hyperloglog_test, serialisation)
+{
+    chopper::sketch::sparse_hyperloglog const sketch{random_sketch(100u, 5u)};
+    chopper::sketch::sparse_hyperloglog loaded{};
+
+    std::stringstream buffer{};
+    {
+        cereal::BinaryOutputArchive oarchive{buffer};
+        oarchive(sketch);
+    }
+    {
+        cereal::BinaryInputArchive iarchive{buffer};
+        iarchive(loaded);
+    }
+
+    EXPECT_EQ(loaded.data_size(), sketch.data_size());
+    EXPECT_EQ(loaded.is_sparse(), sketch.is_sparse());
+    EXPECT_EQ(loaded.estimate(), sketch.estimate());
+}
+
+TEST(sparse_hyperloglog_test, to_dense_sketches)
+{
+    std::vector<seqan::hibf::sketch::hyperloglog> const dense{random_sketch(10u, 5u), random_sketch(100000u, 6u)};
+    std::vector<chopper::sketch::sparse_hyperloglog> sparse = chopper::sketch::to_sparse_sketches(dense);
+
+    auto const copied = chopper::sketch::to_dense_sketches(sparse);
+    auto const moved = chopper::sketch::to_dense_sketches(std::move(sparse));
+
+    ASSERT_EQ(moved.size(), dense.size());
+    for (size_t i = 0; i < dense.size(); ++i)
+    {
+        EXPECT_EQ(copied[i].estimate(), dense[i].estimate());
+        EXPECT_EQ(moved[i].estimate(), dense[i].estimate());
+    }
+    EXPECT_TRUE(sparse.empty()); // NOLINT(bugprone-use-after-move)
+}
@@ -0,0 +1,82 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <seqan3/test/tmp_directory.hpp>
+
+#include <chopper/layout/ibf_query_cost.hpp>
+
+#include "cli_test.hpp"
+
+TEST_F(cli_test, chopper_calibrate_and_layout)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const input_filename{tmp_dir.path() / "data.filenames"};
+    std::filesystem::path const table_filename{tmp_dir.path() / "query_cost.tsv"};
+    std::filesystem::path const layout_filename{tmp_dir.path() / "output.binning"};
+
+    {
+        std::ofstream fout{input_filename};
+        fout << data("seq1.fa").string() << '\n'
+             << data("seq2.fa").string() << '\n'
+             << data("seq3.fa").string() << '\n';
+    }
+
+    cli_test_result result = execute_app("chopper",
+                                         "calibrate",
+                                         "--output",
+                                         table_filename.c_str(),
+                                         "--fpr 0.05",
+                                         "--max-tmax 128",
+                                         "--elements 100",
+                                         "--queries 10",
+                                         "--repetitions 1");
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err, std::string{});
+
+    chopper::layout::ibf_query_cost const cost = chopper::layout::ibf_query_cost::read_from(table_filename);
+    auto const & table = cost.table();
+    ASSERT_EQ(table.size(), 1u);
+    EXPECT_EQ(table.begin()->first, 0.05);
+    EXPECT_EQ(table.begin()->second[0], 1.0);
+
+    result = execute_app("chopper",
+                         "layout",
+                         "--kmer 15",
+                         "--tmax 64",
+                         "--determine-best-tmax",
+                         "--input",
+                         input_filename.c_str(),
+                         "--query-cost-table",
+                         table_filename.c_str(),
+                         "--output",
+                         layout_filename.c_str());
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.err, std::string{});
+    EXPECT_TRUE(std::filesystem::exists(layout_filename));
+}
+
+TEST_F(cli_test, chopper_calibrate_invalid_max_tmax)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const table_filename{tmp_dir.path() / "query_cost.tsv"};
+
+    cli_test_result result =
+        execute_app("chopper", "calibrate", "--output", table_filename.c_str(), "--max-tmax 100");
+
+    EXPECT_NE(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err, std::string{"[ERROR] The --max-tmax must be a power of two in [64, 65536].\n"});
+}
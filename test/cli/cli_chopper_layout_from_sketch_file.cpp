@@ -10,11 +10,13 @@
 #include <filesystem>
 #include <fstream>
 #include <string> // strings
+#include <vector>
 
 #include <seqan3/test/tmp_directory.hpp>
 
 #include <chopper/input_functor.hpp>
 #include <chopper/sketch/sketch_file.hpp>
+#include <chopper/sketch/sparse_hyperloglog.hpp>
 
 #include <hibf/sketch/compute_sketches.hpp>
 
@@ -40,10 +42,15 @@ TEST_F(cli_test, chopper_layout_from_sketch_file)
         sout.chopper_config.k = 19;
         sout.chopper_config.hibf_config.sketch_bits = 12;
         sout.chopper_config.hibf_config.input_fn =
-            chopper::input_functor{sout.filenames, false, sout.chopper_config.k, sout.chopper_config.window_size};
+            chopper::input_functor{chopper::make_filename_store(sout.filenames),
+                                   false,
+                                   sout.chopper_config.k,
+                                   sout.chopper_config.window_size};
         sout.chopper_config.hibf_config.number_of_user_bins = sout.filenames.size();
 
-        seqan::hibf::sketch::compute_sketches(sout.chopper_config.hibf_config, sout.hll_sketches);
+        std::vector<seqan::hibf::sketch::hyperloglog> sketches{};
+        seqan::hibf::sketch::compute_sketches(sout.chopper_config.hibf_config, sketches);
+        sout.hll_sketches = chopper::sketch::to_sparse_sketches(sketches);
 
         std::ofstream os{input_filename, std::ios::binary};
         cereal::BinaryOutputArchive oarchive{os};
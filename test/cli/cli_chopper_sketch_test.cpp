@@ -0,0 +1,285 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <seqan3/test/tmp_directory.hpp>
+
+#include <chopper/sketch/sketch_file.hpp>
+
+#include "cli_test.hpp"
+
+TEST_F(cli_test, chopper_sketch_shards_and_merge)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const input_filename{tmp_dir.path() / "data.filenames"};
+    std::filesystem::path const shard0_filename{tmp_dir.path() / "shard0.sketch"};
+    std::filesystem::path const shard1_filename{tmp_dir.path() / "shard1.sketch"};
+    std::filesystem::path const merged_filename{tmp_dir.path() / "merged.sketch"};
+    std::filesystem::path const layout_filename{tmp_dir.path() / "output.binning"};
+
+    {
+        std::ofstream fout{input_filename};
+        fout << data("seq1.fa").string() << '\n'
+             << data("seq2.fa").string() << '\n'
+             << data("seq3.fa").string() << '\n';
+    }
+
+    cli_test_result result = execute_app("chopper",
+                                         "sketch",
+                                         "--kmer 15",
+                                         "--input",
+                                         input_filename.c_str(),
+                                         "--shard 1/2",
+                                         "--output",
+                                         shard1_filename.c_str());
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err, std::string{});
+
+    // Merging fails as long as not all shards are present.
+    result = execute_app("chopper",
+                         "merge-sketches",
+                         "--input",
+                         shard1_filename.c_str(),
+                         "--output",
+                         merged_filename.c_str());
+
+    EXPECT_NE(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_NE(result.err, std::string{});
+
+    result = execute_app("chopper",
+                         "sketch",
+                         "--kmer 15",
+                         "--input",
+                         input_filename.c_str(),
+                         "--shard 0/2",
+                         "--output",
+                         shard0_filename.c_str());
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err, std::string{});
+
+    // A sketch file of a single shard cannot be laid out.
+    result = execute_app("chopper", "layout", "--input", shard0_filename.c_str(), "--output", layout_filename.c_str());
+
+    EXPECT_NE(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_NE(result.err, std::string{});
+
+    // The order of the shards on the command line does not matter.
+    result = execute_app("chopper",
+                         "merge-sketches",
+                         "--input",
+                         shard1_filename.c_str(),
+                         "--input",
+                         shard0_filename.c_str(),
+                         "--output",
+                         merged_filename.c_str());
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err, std::string{});
+
+    ASSERT_TRUE(std::filesystem::exists(merged_filename));
+
+    {
+        chopper::sketch::sketch_file sin{};
+        std::ifstream is{merged_filename};
+        cereal::BinaryInputArchive iarchive{is};
+        iarchive(sin);
+
+        EXPECT_EQ(sin.chopper_config.k, 15);
+        EXPECT_EQ(sin.shard_index, 0u);
+        EXPECT_EQ(sin.number_of_shards, 1u);
+        ASSERT_EQ(sin.filenames.size(), 3u);
+        EXPECT_EQ(sin.hll_sketches.size(), 3u);
+        EXPECT_EQ(sin.filenames[0][0], data("seq1.fa").string());
+        EXPECT_EQ(sin.filenames[1][0], data("seq2.fa").string());
+        EXPECT_EQ(sin.filenames[2][0], data("seq3.fa").string());
+    }
+
+    result = execute_app("chopper",
+                         "layout",
+                         "--input",
+                         merged_filename.c_str(),
+                         "--tmax 64",
+                         "--output",
+                         layout_filename.c_str());
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err, std::string{});
+    EXPECT_TRUE(std::filesystem::exists(layout_filename));
+}
+
+TEST_F(cli_test, chopper_sketch_shards_by_hash)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const input_filename{tmp_dir.path() / "data.filenames"};
+    std::filesystem::path const merged_filename{tmp_dir.path() / "merged.sketch"};
+    std::filesystem::path const expected_filename{tmp_dir.path() / "expected.sketch"};
+
+    {
+        std::ofstream fout{input_filename};
+        fout << data("seq1.fa").string() << '\n'
+             << data("seq2.fa").string() << '\n'
+             << data("seq3.fa").string() << '\n';
+    }
+
+    std::vector<std::string> shard_filenames{};
+
+    for (size_t i = 0; i < 3u; ++i)
+    {
+        shard_filenames.push_back((tmp_dir.path() / ("shard" + std::to_string(i) + ".sketch")).string());
+        std::string const shard{"--shard " + std::to_string(i) + "/3"};
+
+        cli_test_result result = execute_app("chopper",
+                                             "sketch",
+                                             "--kmer 15",
+                                             "--shard-by-hash",
+                                             "--input",
+                                             input_filename.c_str(),
+                                             shard.c_str(),
+                                             "--output",
+                                             shard_filenames.back().c_str());
+
+        EXPECT_EQ(result.exit_code, 0);
+        EXPECT_EQ(result.out, std::string{});
+        EXPECT_EQ(result.err, std::string{});
+    }
+
+    cli_test_result result = execute_app("chopper",
+                                         "merge-sketches",
+                                         "--input",
+                                         shard_filenames[2].c_str(),
+                                         "--input",
+                                         shard_filenames[0].c_str(),
+                                         "--input",
+                                         shard_filenames[1].c_str(),
+                                         "--output",
+                                         merged_filename.c_str());
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err, std::string{});
+
+    result = execute_app("chopper",
+                         "sketch",
+                         "--kmer 15",
+                         "--input",
+                         input_filename.c_str(),
+                         "--output",
+                         expected_filename.c_str());
+
+    EXPECT_EQ(result.exit_code, 0);
+
+    chopper::sketch::sketch_file merged{};
+    chopper::sketch::sketch_file expected{};
+
+    {
+        std::ifstream is{merged_filename};
+        cereal::BinaryInputArchive iarchive{is};
+        iarchive(merged);
+    }
+    {
+        std::ifstream is{expected_filename};
+        cereal::BinaryInputArchive iarchive{is};
+        iarchive(expected);
+    }
+
+    ASSERT_EQ(merged.filenames.size(), 3u);
+    ASSERT_EQ(merged.hll_sketches.size(), 3u);
+    EXPECT_EQ(merged.filenames, expected.filenames);
+
+    for (size_t i = 0; i < 3u; ++i)
+        EXPECT_EQ(merged.hll_sketches[i].estimate(), expected.hll_sketches[i].estimate());
+}
+
+TEST_F(cli_test, chopper_merge_sketches_inconsistent_parameters)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const input_filename{tmp_dir.path() / "data.filenames"};
+    std::filesystem::path const shard0_filename{tmp_dir.path() / "shard0.sketch"};
+    std::filesystem::path const shard1_filename{tmp_dir.path() / "shard1.sketch"};
+    std::filesystem::path const merged_filename{tmp_dir.path() / "merged.sketch"};
+
+    {
+        std::ofstream fout{input_filename};
+        fout << data("seq1.fa").string() << '\n' << data("seq2.fa").string() << '\n';
+    }
+
+    cli_test_result result = execute_app("chopper",
+                                         "sketch",
+                                         "--kmer 15",
+                                         "--input",
+                                         input_filename.c_str(),
+                                         "--shard 0/2",
+                                         "--output",
+                                         shard0_filename.c_str());
+    EXPECT_EQ(result.exit_code, 0);
+
+    result = execute_app("chopper",
+                         "sketch",
+                         "--kmer 17",
+                         "--input",
+                         input_filename.c_str(),
+                         "--shard 1/2",
+                         "--output",
+                         shard1_filename.c_str());
+    EXPECT_EQ(result.exit_code, 0);
+
+    result = execute_app("chopper",
+                         "merge-sketches",
+                         "--input",
+                         shard0_filename.c_str(),
+                         "--input",
+                         shard1_filename.c_str(),
+                         "--output",
+                         merged_filename.c_str());
+
+    EXPECT_NE(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err,
+              std::string{"[ERROR] The sketch file " + shard1_filename.string()
+                          + " was computed with a k-mer size of 17, but the first non-empty sketch file with a "
+                            "k-mer size of 15. All shards must be sketched with the same parameters.\n"});
+    EXPECT_FALSE(std::filesystem::exists(merged_filename));
+}
+
+TEST_F(cli_test, chopper_sketch_invalid_shard)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const input_filename{tmp_dir.path() / "data.filenames"};
+    std::filesystem::path const sketch_filename{tmp_dir.path() / "out.sketch"};
+
+    {
+        std::ofstream fout{input_filename};
+        fout << data("seq1.fa").string() << '\n';
+    }
+
+    cli_test_result result = execute_app("chopper",
+                                         "sketch",
+                                         "--input",
+                                         input_filename.c_str(),
+                                         "--shard 2/2",
+                                         "--output",
+                                         sketch_filename.c_str());
+
+    EXPECT_NE(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err,
+              std::string{"[ERROR] The --shard must have the format \"i/n\" with 0 <= i < n, but is \"2/2\".\n"});
+}
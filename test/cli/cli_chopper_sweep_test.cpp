@@ -0,0 +1,94 @@
+// ---------------------------------------------------------------------------------------------------
+// Copyright (c) 2006-2023, Knut Reinert & Freie Universität Berlin
+// Copyright (c) 2016-2023, Knut Reinert & MPI für molekulare Genetik
+// This file may be used, modified and/or redistributed under the terms of the 3-clause BSD-License
+// shipped with this file and also available at: https://github.com/seqan/chopper/blob/main/LICENSE.md
+// ---------------------------------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <seqan3/test/tmp_directory.hpp>
+
+#include "cli_test.hpp"
+
+TEST_F(cli_test, chopper_sweep)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const input_filename{tmp_dir.path() / "data.filenames"};
+    std::filesystem::path const sketch_filename{tmp_dir.path() / "data.sketch"};
+    std::filesystem::path const table_filename{tmp_dir.path() / "sweep.tsv"};
+
+    {
+        std::ofstream fout{input_filename};
+        fout << data("seq1.fa").string() << '\n'
+             << data("seq2.fa").string() << '\n'
+             << data("seq3.fa").string() << '\n';
+    }
+
+    cli_test_result result = execute_app("chopper",
+                                         "sketch",
+                                         "--kmer 15",
+                                         "--input",
+                                         input_filename.c_str(),
+                                         "--output",
+                                         sketch_filename.c_str());
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.err, std::string{});
+
+    result = execute_app("chopper",
+                         "sweep",
+                         "--input",
+                         sketch_filename.c_str(),
+                         "--fpr 0.01",
+                         "--fpr 0.05",
+                         "--hash 2",
+                         "--hash 3",
+                         "--tmax 64",
+                         "--threads 2",
+                         "--output",
+                         table_filename.c_str());
+
+    EXPECT_EQ(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err, std::string{});
+
+    std::ifstream table{table_filename};
+    std::string line{};
+    std::getline(table, line);
+    EXPECT_EQ(line, "# fpr\trelaxed_fpr\thash\talpha\ttmax\tlevels\tsize_in_bytes\tsize\texpected_query_cost");
+
+    std::string const expected_prefixes[]{"0.01\t0.3\t2\t1.2\t64\t1\t",
+                                          "0.01\t0.3\t3\t1.2\t64\t1\t",
+                                          "0.05\t0.3\t2\t1.2\t64\t1\t",
+                                          "0.05\t0.3\t3\t1.2\t64\t1\t"};
+    for (std::string const & expected_prefix : expected_prefixes)
+    {
+        ASSERT_TRUE(std::getline(table, line));
+        EXPECT_TRUE(line.starts_with(expected_prefix)) << line;
+    }
+    EXPECT_FALSE(std::getline(table, line));
+}
+
+TEST_F(cli_test, chopper_sweep_needs_sketch_file)
+{
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const input_filename{tmp_dir.path() / "data.filenames"};
+    std::filesystem::path const table_filename{tmp_dir.path() / "sweep.tsv"};
+
+    {
+        std::ofstream fout{input_filename};
+        fout << data("seq1.fa").string() << '\n';
+    }
+
+    cli_test_result result =
+        execute_app("chopper", "sweep", "--input", input_filename.c_str(), "--output", table_filename.c_str());
+
+    EXPECT_NE(result.exit_code, 0);
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_NE(result.err, std::string{});
+}
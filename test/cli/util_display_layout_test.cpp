@@ -219,3 +219,59 @@ LEVEL	BIT_SIZE	IBFS	AVG_LOAD_FACTOR	TBS_TOO_BIG	AVG_TBS_TOO_BIG_ELEMENTS	AVG_MAX
     std::string const actual_file{string_from_file(sizes_filename)};
     EXPECT_EQ(expected_general_file, actual_file);
 }
+
+TEST_F(cli_test, display_layout_diff)
+{
+    std::string const seq1_filename = data("seq1.fa");
+    std::string const seq2_filename = data("seq2.fa");
+    std::string const seq3_filename = data("seq3.fa");
+    std::string const small_filename = data("small.fa");
+    seqan3::test::tmp_directory tmp_dir{};
+    std::filesystem::path const previous_filename{tmp_dir.path() / "previous.layout"};
+    std::filesystem::path const layout_filename{tmp_dir.path() / "small.layout"};
+    std::filesystem::path const diff_filename{tmp_dir.path() / "small.layout.diff"};
+
+    std::string const previous_layout = get_layout_with_correct_filenames(seq1_filename,
+                                                                          seq2_filename,
+                                                                          seq3_filename,
+                                                                          small_filename,
+                                                                          layout_filename.string());
+
+    // User bin 3 moves from the technical bins 2 and 3 to the technical bin 3 of the top-level IBF.
+    std::string layout{previous_layout};
+    layout.replace(layout.rfind("3\t2\t2\n"), 6u, "3\t3\t1\n");
+
+    {
+        std::ofstream fout{previous_filename};
+        fout << previous_layout;
+    }
+    {
+        std::ofstream fout{layout_filename};
+        fout << layout;
+    }
+
+    cli_test_result result = execute_app("display_layout",
+                                         "diff",
+                                         "--input",
+                                         layout_filename.c_str(),
+                                         "--previous",
+                                         previous_filename.c_str(),
+                                         "--output",
+                                         diff_filename.c_str());
+
+    ASSERT_EQ(result.exit_code, 0) << "PWD: " << result.pwd << "\nCMD: " << result.command;
+    EXPECT_EQ(result.out, std::string{});
+    EXPECT_EQ(result.err, std::string{});
+
+    // The lower-level IBF of the merged bin 0 is unchanged.
+    std::string const expected_diff_file{R"(# No sketch file found: each user bin counts as one k-mer.
+# IBFs to rebuild: 1 of 2
+# User bins: 1 moved, 0 added, 0 removed
+# K-mers to insert: 4 of 6 (66.67%)
+IBF	USER_BINS	KMERS
+HIGH_LEVEL_IBF	4	4
+)"};
+
+    std::string const actual_file{string_from_file(diff_filename)};
+    EXPECT_EQ(expected_diff_file, actual_file);
+}